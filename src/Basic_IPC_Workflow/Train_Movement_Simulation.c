@@ -15,77 +15,512 @@
 #include <errno.h>
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <time.h>
+#include <ctype.h>
+#include <sys/stat.h>
 
 #include "logger.h"       // log_init, LOG_CLIENT, log_close
-#include "parser.h"       // getTrains, TrainEntry
+#include "parser.h"       // getTrains, Scenario, TrainEntry
+#include "ipc.h"          // Message, MSG_KEY, send_set_message
 #include "resource_allocation_graph.h"
+#include "trace.h"        // trace_open, trace_event
+#include "rail_probes.h"  // USDT probes
+#include "journey.h"      // per-hop time breakdown
 #include "../Shared_Memory_Setup/Memory_Segments.h" // SharedIntersection
 
-#define MSG_KEY    1234
-#define MAX_NAME   64
+static JourneyTrain *journey = NULL; // this train's slot in the journey table (child only)
+
+// send RELEASE then WAIT OK. Time since *since is charged to traversing hop, then the ack
+static void release_intersection(int msgid, int train_id, const char *intersection,
+                                 JourneyHop *hop, JourneyStamp *since) {
+    Message req, resp;
+    memset(&req, 0, sizeof(req));
+    req.mtype    = 1;
+    req.train_id = train_id;
+    strncpy(req.intersection, intersection, MAX_NAME-1);
+    snprintf(req.action, sizeof(req.action), "RELEASE");
+    journey_add(hop, JOURNEY_TRAVERSE, since);
+    if (msgsnd(msgid, &req, sizeof(req)-sizeof(long), 0) == -1) {
+        LOG_TRAIN_AT(LOG_LEVEL_ERROR, train_id, "msgsnd(RELEASE) failed: %s", strerror(errno));
+        exit(1);
+    }
+    trace_event(train_id, intersection, TRACE_OP_RELEASE, TRACE_RES_NONE);
+    LOG_TRAIN_AT(LOG_LEVEL_DEBUG, train_id, "Sent RELEASE for %s", intersection);
+
+    // wait for OK 
+    do {
+        if (msgrcv(msgid, &resp, sizeof(resp)-sizeof(long),
+                   train_id+100, 0) == -1) {
+            LOG_TRAIN_AT(LOG_LEVEL_ERROR, train_id, "msgrcv(OK) failed: %s", strerror(errno));
+            exit(1);
+        }
+        LOG_TRAIN_AT(LOG_LEVEL_DEBUG, train_id, "Received %s for %s",
+                  resp.action, resp.intersection);
+    } while (strcmp(resp.action, "OK") != 0);
+    journey_add(hop, JOURNEY_ACK, since);
+    trace_event(train_id, intersection, TRACE_OP_RELEASE, TRACE_RES_OK);
+}
+
+// what a train does when the server answers TIMEOUT
+typedef enum {
+    ON_TIMEOUT_RETRY,    // back off and ask for the same intersection again
+    ON_TIMEOUT_REROUTE,  // move the intersection to the end of the remaining route
+    ON_TIMEOUT_ABORT     // give up, the train exits with status 2
+} TimeoutAction;
 
-// IPC message format 
 typedef struct {
-    long mtype;               // 1 for requests
-    int  train_id;
-    char intersection[MAX_NAME];
-    char action[8];           // "ACQUIRE", "RELEASE"
-} Message;
+    int timeout_ms;          // 0 = wait for GRANT forever (original behaviour)
+    int max_retries;         // timeouts in a row before the train gives up
+    TimeoutAction on_timeout;
+} AcquirePolicy;
+
+// outcome of waiting for the server's answer to ACQUIRE or ACQ_SET
+enum { ACQ_GRANTED, ACQ_TIMED_OUT };
+
+// reads replies until GRANT or TIMEOUT. FAIL or a queue error ends the train.
+// op is the request being answered, for the trace. The first reply ends the hop's
+// queued time, GRANT or TIMEOUT ends its capacity wait
+static int wait_for_grant(int msgid, int train_id, int op, JourneyHop *hop, JourneyStamp *since) {
+    Message resp;
+    int first = 1;
+    for (;;) {
+        if (msgrcv(msgid, &resp, sizeof(resp)-sizeof(long),
+                   train_id+100, 0) == -1) {
+            LOG_TRAIN_AT(LOG_LEVEL_ERROR, train_id, "msgrcv(GRANT) failed: %s", strerror(errno));
+            exit(1);
+        }
+        LOG_TRAIN_AT(LOG_LEVEL_DEBUG, train_id, "Received %s for %s",
+                  resp.action, resp.intersection);
+        trace_event(train_id, resp.intersection, op, trace_result_code(resp.action));
+        if (first) {
+            journey_add(hop, JOURNEY_QUEUED, since);
+            first = 0;
+        }
+        if (strcmp(resp.action, "GRANT") == 0) {
+            journey_add(hop, JOURNEY_CAPACITY, since);
+            return ACQ_GRANTED;
+        }
+        if (strcmp(resp.action, "TIMEOUT") == 0) {
+            journey_add(hop, JOURNEY_CAPACITY, since);
+            return ACQ_TIMED_OUT;
+        }
+        if (strcmp(resp.action, "FAIL") == 0) exit(1);
+    }
+}
+
+// handles one TIMEOUT. Returns 1 if the caller should reroute, 0 to retry; exits on abort
+static int after_timeout(int train_id, const AcquirePolicy *policy, int attempt) {
+    if (policy->on_timeout == ON_TIMEOUT_ABORT || attempt > policy->max_retries) {
+        LOG_TRAIN_AT(LOG_LEVEL_WARN, train_id, "Aborting after %d timeout(s)", attempt);
+        exit(2);
+    }
+    if (policy->on_timeout == ON_TIMEOUT_REROUTE) return 1;
+
+    // exponential backoff with jitter so timed-out trains don't come back in lockstep
+    long base_ms = 50L << (attempt - 1 < 5 ? attempt - 1 : 5);
+    long delay_ms = base_ms + rand() % base_ms;
+    LOG_TRAIN(train_id, "Timed out, retry %d in %ld ms", attempt, delay_ms);
+    struct timespec pause = { delay_ms / 1000, (delay_ms % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+    return 0;
+}
 
 // each trains workflow: ACQUIRE then WAIT then GRANT then TRAVEL then RELEASE then WAIT OK
-void run_train(int msgid, int train_id, char *route[], int route_len) {
+void run_train(int msgid, int train_id, const char *route[], int route_len, const AcquirePolicy *policy) {
     //moved generation of comp string to macro in logger.h
-    Message req, resp;
-    for (int i = 0; i < route_len; i++) {
+    Message req;
+    memset(&req, 0, sizeof(req));
+    int attempt = 0; // timeouts in a row
+    JourneyHop *hop = NULL; // open until its RELEASE is acknowledged
+    JourneyStamp since;
+    for (int i = 0; i < route_len; ) {
+        if (!hop) {
+            hop = journey_next_hop(journey, route[i]);
+            since = journey_now();
+        } else {
+            journey_add(hop, JOURNEY_CAPACITY, &since); // backoff before this retry
+        }
+
         // send ACQUIRE
         req.mtype      = 1;
         req.train_id   = train_id;
+        req.timeout_ms = policy->timeout_ms;
         strncpy(req.intersection, route[i], MAX_NAME-1);
         req.intersection[MAX_NAME-1] = '\0';
         snprintf(req.action, sizeof(req.action), "ACQUIRE");
         
         if (msgsnd(msgid, &req, sizeof(req)-sizeof(long), 0) == -1) {
-            LOG_TRAIN(train_id, "msgsnd(ACQUIRE) failed: %s", strerror(errno));
+            LOG_TRAIN_AT(LOG_LEVEL_ERROR, train_id, "msgsnd(ACQUIRE) failed: %s", strerror(errno));
             exit(1);
         }
-        LOG_TRAIN(train_id, "Sent ACQUIRE request for %s", route[i]);
+        trace_event(train_id, route[i], TRACE_OP_ACQUIRE, TRACE_RES_NONE);
+        RAIL_PROBE2(acquire_sent, train_id, route[i]);
+        LOG_TRAIN_AT(LOG_LEVEL_DEBUG, train_id, "Sent ACQUIRE request for %s", route[i]);
 
         // wait only for grant
-        do {
-            if (msgrcv(msgid, &resp, sizeof(resp)-sizeof(long),
-                       train_id+100, 0) == -1) {
-                LOG_TRAIN(train_id, "msgrcv(GRANT) failed: %s", strerror(errno));
-                exit(1);
+        if (wait_for_grant(msgid, train_id, TRACE_OP_ACQUIRE, hop, &since) == ACQ_TIMED_OUT) {
+            if (after_timeout(train_id, policy, ++attempt) && i < route_len - 1) {
+                // try the rest of the route first and come back to this one
+                const char *later = route[i];
+                for (int j = i; j < route_len - 1; j++) route[j] = route[j+1];
+                route[route_len - 1] = later;
+                LOG_TRAIN(train_id, "Rerouting: %s moved to the end of the route", later);
+                hop = NULL; // the abandoned attempt keeps its own hop
             }
-            LOG_TRAIN(train_id, "Received %s for %s",
-                      resp.action, resp.intersection);
-        } while (strcmp(resp.action, "GRANT") != 0);
+            continue;
+        }
+        RAIL_PROBE2(grant_received, train_id, route[i]);
+        attempt = 0;
 
         // simulate traversal
         sleep(1);
 
-        // send RELEASE
-        snprintf(req.action, sizeof(req.action), "RELEASE");
-        if (msgsnd(msgid, &req, sizeof(req)-sizeof(long), 0) == -1) {
-            LOG_TRAIN(train_id, "msgsnd(RELEASE) failed: %s", strerror(errno));
+        release_intersection(msgid, train_id, route[i], hop, &since);
+        hop = NULL;
+        i++;
+    }
+}
+
+// ordered workflow: ACQ_SET for the next `window` intersections, WAIT for the GRANT of
+// the whole set, then TRAVEL and RELEASE each one in route order.
+// A train never asks for anything while it holds something, and the server takes every
+// set in the same global order, so trains in this mode cannot deadlock.
+void run_train_ordered(int msgid, int train_id, const char *route[], int route_len, int window,
+                       const AcquirePolicy *policy) {
+    int attempt = 0; // timeouts in a row
+    JourneyHop *hop = NULL; // first hop of the window, carries the set's queued and capacity time
+    JourneyStamp since;
+    int i = 0;
+    while (i < route_len) {
+        // cut the window short if the route comes back to an intersection already in it,
+        // otherwise the first release would give up the second visit
+        int count = 0;
+        while (count < window && i + count < route_len) {
+            int repeat = 0;
+            for (int j = i; j < i + count; j++) {
+                if (strcmp(route[j], route[i + count]) == 0) repeat = 1;
+            }
+            if (repeat) break;
+            count++;
+        }
+
+        if (!hop) {
+            hop = journey_next_hop(journey, route[i]);
+            since = journey_now();
+        } else {
+            journey_add(hop, JOURNEY_CAPACITY, &since); // backoff before this retry
+        }
+
+        send_set_message(msgid, train_id, &route[i], count, policy->timeout_ms);
+        trace_event(train_id, route[i], TRACE_OP_ACQ_SET, TRACE_RES_NONE);
+        RAIL_PROBE2(acquire_sent, train_id, route[i]);
+        LOG_TRAIN(train_id, "Sent ACQ_SET request for %d intersections starting at %s",
+                  count, route[i]);
+
+        // wait only for grant. Sets are not rerouted, a timeout just retries the window
+        if (wait_for_grant(msgid, train_id, TRACE_OP_ACQ_SET, hop, &since) == ACQ_TIMED_OUT) {
+            AcquirePolicy retry = *policy;
+            if (retry.on_timeout == ON_TIMEOUT_REROUTE) retry.on_timeout = ON_TIMEOUT_RETRY;
+            after_timeout(train_id, &retry, ++attempt);
+            continue;
+        }
+        RAIL_PROBE2(grant_received, train_id, route[i]);
+        attempt = 0;
+
+        for (int j = i; j < i + count; j++) {
+            // simulate traversal
+            sleep(1);
+            JourneyHop *h = (j == i) ? hop : journey_next_hop(journey, route[j]);
+            release_intersection(msgid, train_id, route[j], h, &since);
+        }
+        hop = NULL;
+        i += count;
+    }
+}
+
+// what every train child needs besides its route
+typedef struct {
+    int msgid;
+    int window;              // > 0: ordered mode
+    AcquirePolicy policy;
+} TrainSetup;
+
+// every train started so far, in start order; a train's slot is its index here
+typedef struct {
+    pid_t *pids;
+    int *ids;                // the N of TrainN, for the exit log
+    int count, cap;
+    int running;
+} Fleet;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#define TRAIN_ID_MAX 999999 // reply mtype is train_id + 100, id 0 is the server
+
+// the N of a train named TrainN, or -1 for any other name. Trains are told apart
+// by that number in messages and traces, so it must be there and not 0, and without
+// leading zeros, so that two distinct names (which the parser ensures) are two numbers
+static int train_number(const char *name) {
+    if (strncmp(name, "Train", 5) != 0 || name[5] < '1' || name[5] > '9') return -1;
+    char *end;
+    long id = strtol(name + 5, &end, 10);
+    if (*end != '\0' || id < 1 || id > TRAIN_ID_MAX) return -1;
+    return (int)id;
+}
+
+// forks the child for train `train` of sc, in journey slot fleet->count.
+// Returns -1 without starting it if its name gives no train number
+static int spawn_train(const Scenario *sc, int train, const TrainSetup *setup, Fleet *fleet) {
+    TrainEntry entry = scenario_train(sc, train);
+    int train_id = train_number(entry.id);
+    if (train_id == -1) {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Train name %s is not Train<number>, not started", entry.id);
+        fprintf(stderr, "train_sim: %s is not named Train<number> (1 to %d), not started\n", entry.id, TRAIN_ID_MAX);
+        return -1;
+    }
+
+    if (fleet->count == fleet->cap) {
+        int cap = fleet->cap ? 2 * fleet->cap : 64;
+        pid_t *pids = realloc(fleet->pids, cap * sizeof(pid_t));
+        if (pids) fleet->pids = pids;
+        int *ids = realloc(fleet->ids, cap * sizeof(int));
+        if (ids) fleet->ids = ids;
+        if (!pids || !ids) {
+            LOG_SERVER_AT(LOG_LEVEL_ERROR, "Out of memory for %d trains", cap);
             exit(1);
         }
-        LOG_TRAIN(train_id, "Sent RELEASE for %s", route[i]);
+        fleet->cap = cap;
+    }
+    int slot = fleet->count;
 
-        // wait for OK 
-        do {
-            if (msgrcv(msgid, &resp, sizeof(resp)-sizeof(long),
-                       train_id+100, 0) == -1) {
-                LOG_TRAIN(train_id, "msgrcv(OK) failed: %s", strerror(errno));
-                exit(1);
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "fork failed: %s", strerror(errno));
+        exit(1);
+    }
+    if (pid == 0) {
+        // child: run its train
+        // build the route pointer array; run_train reorders it on a reroute
+        int len = entry.routeLength;
+        const char **routePtrs = malloc(len * sizeof(char *));
+        if (!routePtrs) exit(1);
+        for (int j = 0; j < len; j++)
+            routePtrs[j] = scenario_name(sc, entry.route[j]);
+
+        srand(getpid()); // different backoff jitter per train
+        char role[16];
+        snprintf(role, sizeof(role), "train%d", train_id);
+        flight_attach(role); // off if the server has no flight recorder
+        journey = journey_claim(slot, train_id);
+        const char *trace_dir = getenv("RAIL_TRACE");
+        if (trace_dir) {
+            trace_open(trace_dir, role); // closed by its exit hook
+        }
+        if (setup->window > 0)
+            run_train_ordered(setup->msgid, train_id, routePtrs, len, setup->window, &setup->policy);
+        else
+            run_train(setup->msgid, train_id, routePtrs, len, &setup->policy);
+        exit(0);
+    }
+    // parent: record child's PID
+    fleet->pids[fleet->count] = pid;
+    fleet->ids[fleet->count++] = train_id;
+    fleet->running++;
+    return 0;
+}
+
+// waits for one train to finish (options 0) or collects those that already have
+// (WNOHANG) and logs their exit status. Returns how many it collected
+static int reap_trains(Fleet *fleet, int options) {
+    int reaped = 0;
+    int status;
+    pid_t finished_pid;
+    while (fleet->running > 0 && (finished_pid = waitpid(-1, &status, options)) > 0) {
+        // recent trains are at the end
+        for (int i = fleet->count - 1; i >= 0; i--) {
+            if (fleet->pids[i] == finished_pid) {
+                if (WIFEXITED(status)) {//if exited, log exit status
+                    LOG_SERVER("Train %d exited with status %d", fleet->ids[i], WEXITSTATUS(status));
+                }
+                break;
+            }
+        }
+        fleet->running--;
+        reaped++;
+        if (options == 0) break;
+    }
+    return reaped;
+}
+
+// STREAMING
+// -s source: trains arrive while the simulation runs, one "[offset_ms] Train:hop,hop"
+// line each, from a FIFO, a file that is still being appended, or - for stdin.
+// A line with an offset starts its train offset_ms after the stream was opened (at
+// once if that time has passed), a line without one starts it when the line arrives.
+// Arrivals do not wait for earlier trains to finish, so a feed with timestamps
+// (railfeed) gives an open-loop load at its own rate. The one limit is the server's:
+// it follows at most MAX_TRAINS trains, so a train due while that many run starts
+// late, and the lateness is reported. The stream ends at a line END or at the end of
+// a FIFO or stdin; a regular file is followed like tail -f until its END.
+#define STREAM_POLL_MS 20
+
+typedef struct {
+    int started;
+    int bad_lines;
+    int timed;               // trains that had an offset
+    uint64_t lag_total_ns;   // how late those started, in all
+    uint64_t lag_max_ns;
+} StreamStats;
+
+static void pause_ms(long ms) {
+    struct timespec pause = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+}
+
+// sleeps until `due` while collecting trains that finish in the meantime
+static void wait_until(uint64_t due, Fleet *fleet) {
+    uint64_t now;
+    while ((now = mono_ns()) < due) {
+        reap_trains(fleet, WNOHANG);
+        uint64_t left_ms = (due - now) / 1000000;
+        pause_ms(left_ms < STREAM_POLL_MS ? (left_ms ? (long)left_ms : 1) : STREAM_POLL_MS);
+    }
+}
+
+static int run_stream(const char *path, const TrainSetup *setup, Fleet *fleet, StreamStats *stats) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r"); // a FIFO blocks here until a writer opens it
+    if (!in) {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Cannot open train stream %s: %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    int follow = fstat(fileno(in), &st) == 0 && S_ISREG(st.st_mode);
+
+    // streamed trains get a scenario of their own; each child inherits it at fork
+    Scenario streamed;
+    if (scenario_init(&streamed) == -1) {
+        if (in != stdin) fclose(in);
+        return -1;
+    }
+    LOG_SERVER("Reading trains from %s%s", path, follow ? " (following)" : "");
+    uint64_t start = mono_ns();
+    char *line = NULL;
+    size_t cap = 0;
+    int line_no = 0;
+    for (;;) {
+        ssize_t len = getline(&line, &cap, in);
+        if (len > 0 && line[len - 1] != '\n' && follow) {
+            // half a line, the writer is not done with it yet
+            fseeko(in, -(off_t)len, SEEK_CUR);
+            len = -1;
+        }
+        if (len == -1) {
+            if (!follow || ferror(in)) break;
+            clearerr(in);
+            reap_trains(fleet, WNOHANG);
+            pause_ms(STREAM_POLL_MS);
+            continue;
+        }
+        line_no++;
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        char *text = line;
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '\0') continue;
+        if (strcmp(text, "END") == 0) break;
+
+        // a leading number and a blank are the offset, anything else is the train
+        int timed = 0;
+        uint64_t due = 0;
+        if (isdigit((unsigned char)*text)) {
+            char *end;
+            unsigned long long offset_ms = strtoull(text, &end, 10);
+            if (*end == ' ' || *end == '\t') {
+                timed = 1;
+                due = start + offset_ms * 1000000ull;
+                text = end;
+                while (*text == ' ' || *text == '\t') text++;
             }
-            LOG_TRAIN(train_id, "Received %s for %s",
-                      resp.action, resp.intersection);
-        } while (strcmp(resp.action, "OK") != 0);
+        }
+        int train = scenario_add_train(&streamed, text, strlen(text), path, line_no);
+        if (train == -1) {
+            stats->bad_lines++; // reported by the parser, the stream goes on
+            continue;
+        }
+
+        if (timed) wait_until(due, fleet);
+        while (fleet->running >= MAX_TRAINS) reap_trains(fleet, 0);
+        if (timed) {
+            uint64_t now = mono_ns();
+            uint64_t lag = now > due ? now - due : 0;
+            stats->timed++;
+            stats->lag_total_ns += lag;
+            if (lag > stats->lag_max_ns) stats->lag_max_ns = lag;
+        }
+        LOG_SERVER_AT(LOG_LEVEL_DEBUG, "Starting streamed %s", scenario_train(&streamed, train).id);
+        if (spawn_train(&streamed, train, setup, fleet) == -1) {
+            stats->bad_lines++;
+            continue;
+        }
+        stats->started++;
     }
+    free(line);
+    if (in != stdin) fclose(in);
+
+    // the children have their copies, the parent's is no longer needed once they finish
+    while (fleet->running > 0) reap_trains(fleet, 0);
+    scenario_free(&streamed);
+    return 0;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    // -w N: ordered mode, each train asks for its next N intersections in one ACQ_SET
+    // -t MS: give up waiting for a GRANT after MS milliseconds
+    // -r N:  timeouts in a row before the train gives up (default 3)
+    // -p retry|reroute|abort: what to do on a timeout (default retry with backoff)
+    // -T trains.txt, -I intersections.txt, -S image: the scenario, as for the server
+    // -s source: take trains from a stream instead of the trains file (see STREAMING)
+    TrainSetup setup = { -1, 0, { 0, 3, ON_TIMEOUT_RETRY } };
+    const char *trains_path = NULL, *intersections_path = NULL, *image_path = NULL, *stream_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "w:t:r:p:T:I:S:s:")) != -1) {
+        switch (opt) {
+        case 'w':
+            setup.window = atoi(optarg);
+            if (setup.window < 1 || setup.window > MAX_WINDOW) {
+                fprintf(stderr, "window must be 1..%d\n", MAX_WINDOW);
+                exit(1);
+            }
+            break;
+        case 't':
+            setup.policy.timeout_ms = atoi(optarg);
+            break;
+        case 'r':
+            setup.policy.max_retries = atoi(optarg);
+            break;
+        case 'p':
+            if (strcmp(optarg, "retry") == 0) setup.policy.on_timeout = ON_TIMEOUT_RETRY;
+            else if (strcmp(optarg, "reroute") == 0) setup.policy.on_timeout = ON_TIMEOUT_REROUTE;
+            else if (strcmp(optarg, "abort") == 0) setup.policy.on_timeout = ON_TIMEOUT_ABORT;
+            else {
+                fprintf(stderr, "policy must be retry, reroute or abort\n");
+                exit(1);
+            }
+            break;
+        case 'T': trains_path = optarg; break;
+        case 'I': intersections_path = optarg; break;
+        case 'S': image_path = optarg; break;
+        case 's': stream_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-w window] [-t timeout_ms] [-r retries] [-p retry|reroute|abort]\n"
+                            "       [-T trains.txt] [-I intersections.txt] [-S scenario.img] [-s stream|-]\n", argv[0]);
+            exit(1);
+        }
+    }
+
     // init logging
     log_init("simulation.log", 0);
     
@@ -102,73 +537,69 @@ int main() {
     LOG_SERVER("Starting train simulator");
 
     // connect to the message queue
-    int msgid = msgget(MSG_KEY, IPC_CREAT | 0666);
-    if (msgid < 0) {
-        LOG_SERVER("msgget failed: %s", strerror(errno));
-        exit(1);
-    }
-    LOG_SERVER("Message queue ready (ID: %d)", msgid);
-
-    // parse trains.txt
-    TrainEntry trains[ITEM_COUNT_MAX];
-    int train_count = getTrains(trains);
-    if (train_count < 0) {
-        LOG_SERVER("Failed to parse trains.txt");
+    setup.msgid = msgget(MSG_KEY, IPC_CREAT | 0666);
+    if (setup.msgid < 0) {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "msgget failed: %s", strerror(errno));
         exit(1);
     }
-    LOG_SERVER("Parsed %d trains", train_count);
+    LOG_SERVER("Message queue ready (ID: %d)", setup.msgid);
+    if (setup.window > 0)
+        LOG_SERVER("Ordered acquisition mode, window of %d intersections", setup.window);
+    if (setup.policy.timeout_ms > 0)
+        LOG_SERVER("Timed acquisition: %d ms, %d retries", setup.policy.timeout_ms, setup.policy.max_retries);
 
-    // fork one child per train
-    pid_t pids[ITEM_COUNT_MAX];
-    for (int i = 0; i < train_count; i++) {
-        // build the route pointer array
-        int len = trains[i].routeLength;
-        char *routePtrs[ITEM_COUNT_MAX];
-        for (int j = 0; j < len; j++)
-            routePtrs[j] = trains[i].route[j];
-
-        // extract numeric ID from "TrainX"
-        int train_id = atoi(trains[i].id + 5);
+    Fleet fleet = { NULL, NULL, 0, 0, 0 };
+    int have_journeys = 0;
 
-        pid_t pid = fork();
-        if (pid < 0) {
-            LOG_SERVER("fork failed: %s", strerror(errno));
+    if (stream_path) {
+        // per-hop timings come back from the children through this mapping; a stream's
+        // fleet is unknown, so it gets room for more than a run is expected to start
+        have_journeys = (journey_create(JOURNEY_STREAM_TRAINS, JOURNEY_STREAM_HOPS) == 0);
+        StreamStats stats;
+        memset(&stats, 0, sizeof(stats));
+        if (run_stream(stream_path, &setup, &fleet, &stats) == -1) exit(1);
+        double lag_mean_ms = stats.timed ? stats.lag_total_ns / 1e6 / stats.timed : 0;
+        LOG_SERVER("Stream ended: %d trains started, %d bad lines, start lag mean %.1f ms, max %.1f ms",
+                   stats.started, stats.bad_lines, lag_mean_ms, stats.lag_max_ns / 1e6);
+        printf("stream %s: %d trains started, %d bad lines; timed arrivals started %.1f ms late on average, %.1f ms at most\n",
+               stream_path, stats.started, stats.bad_lines, lag_mean_ms, stats.lag_max_ns / 1e6);
+    } else {
+        // the same scenario the server loaded (-S/-T/-I, RAIL_SCENARIO or the text files);
+        // routes are ids into its name table, which every child inherits
+        Scenario scenario;
+        if (scenario_open(&scenario, image_path, trains_path, intersections_path) == -1) {
+            LOG_SERVER_AT(LOG_LEVEL_ERROR, "Failed to load the scenario");
             exit(1);
         }
-        if (pid == 0) {
-            // child: run its train
-            run_train(msgid, train_id, routePtrs, len);
-            exit(0);
+        LOG_SERVER("Parsed %d trains", scenario.train_count);
+        int longest = 0;
+        for (int i = 0; i < scenario.train_count; i++) {
+            if (scenario_route_length(&scenario, i) > longest) longest = scenario_route_length(&scenario, i);
         }
-        // parent: record child's PID
-        pids[i] = pid;
-    }
+        have_journeys = (journey_create(scenario.train_count, longest) == 0);
 
-    // wait for all train children to finish
-    int remaining_trains = train_count;
-    while (remaining_trains > 0) { //force wait without forcing order
-        int status;
-        pid_t finished_pid = waitpid(-1, &status, 0);  // Wait for any child to finish
-        
-        for (int i = 0; i < train_count; i++) {
-            if (pids[i] == finished_pid) {
-                if (WIFEXITED(status)) {//if exited, log exit status
-                    LOG_SERVER("Train %d exited with status %d", i+1, WEXITSTATUS(status));
-                }
-                break;
-            }
-        }
-        remaining_trains--; //decrement remaining trains
+        // fork one child per train
+        for (int i = 0; i < scenario.train_count; i++) spawn_train(&scenario, i, &setup, &fleet);
+
+        // wait for all train children to finish, in whatever order they do
+        while (fleet.running > 0) reap_trains(&fleet, 0);
+        scenario_free(&scenario);
+    }
+    LOG_SERVER("All %d trains have finished", fleet.count);
+    free(fleet.pids);
+    free(fleet.ids);
+    if (have_journeys) {
+        journey_report(stdout);
+        journey_destroy();
     }
-    LOG_SERVER("All %d trains have finished", train_count);
 
     // tell the Railway System to stop and wait for acknowledgment
     Message stop = { .mtype = 1, .train_id = 0 };
     memset(stop.intersection, 0, sizeof(stop.intersection));
     snprintf(stop.action, sizeof(stop.action), "STOP");
     
-    if (msgsnd(msgid, &stop, sizeof(stop) - sizeof(long), 0) == -1) {
-        LOG_SERVER("Failed to send STOP: %s", strerror(errno));
+    if (msgsnd(setup.msgid, &stop, sizeof(stop) - sizeof(long), 0) == -1) {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Failed to send STOP: %s", strerror(errno));
     } else {
         LOG_SERVER("Sent STOP to Railway System");
         //log kept printing after complete because of concurrent processes
@@ -176,12 +607,14 @@ int main() {
         sleep(1);
     }
 
+    // logged while the fake clock is still mapped, so it sorts at the right sim time
+    LOG_SERVER("Train simulator exiting");
+
     //unmap the memory to prevent memory leaks
-    munmap(shared_intersections, sizeof(SharedIntersection) * NUM_INTERSECTIONS);
+    munmap(shared_intersections, SHM_SEGMENT_SIZE);
     shared_intersections = NULL;
 
     // exit
-    LOG_SERVER("Train simulator exiting");
     log_close();
     return 0;
 }
\ No newline at end of file
@@ -21,24 +21,24 @@ void setFakeSec(int increment) {
     if (!shared_intersections) return;
     //increments seconds when called by {increment} amount
     //writes to parent process which is accessible to all children (trains)
-    pthread_mutex_lock(&shared_intersections[0].mutex);
+    shm_lock(shared_intersections, 0, LOCK_SITE_CLOCK);
     shared_intersections[0].fakeSec += increment;
     shared_intersections[0].fakeHour = shared_intersections[0].fakeSec / 3600;
     shared_intersections[0].fakeMin = (shared_intersections[0].fakeSec % 3600) / 60;
     shared_intersections[0].fakeMinSec = shared_intersections[0].fakeSec % 60;
-    pthread_mutex_unlock(&shared_intersections[0].mutex);
+    shm_unlock(shared_intersections, 0, LOCK_SITE_CLOCK);
 }
 
 const char* getFakeTime(void) {
     if (!shared_intersections) return "[00:00:00]";
     //creates string in [HH:MM:SS] format
 
-    pthread_mutex_lock(&shared_intersections[0].mutex);
+    shm_lock(shared_intersections, 0, LOCK_SITE_CLOCK);
     snprintf(timeString, sizeof(timeString), "[%02d:%02d:%02d]", 
              shared_intersections[0].fakeHour, 
              shared_intersections[0].fakeMin, 
              shared_intersections[0].fakeMinSec);
-    pthread_mutex_unlock(&shared_intersections[0].mutex);
+    shm_unlock(shared_intersections, 0, LOCK_SITE_CLOCK);
     
     return timeString;
 }
\ No newline at end of file
@@ -9,7 +9,11 @@
 
 #include "intersection_locks.h"
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
 #include "fake_sec.h"
+#include "../logger/logger.h" // LOG_CONSOLE level gate
+#include "../logger/rail_probes.h"
 
 //local time functions. Saves by not have to declare the
 //shared intersection every time we need to call the time functions.
@@ -37,8 +41,9 @@ bool init_mutex_lock(Intersection *intersection) {
         perror("Failed to initialize mutex");
         return false;
     }
+    intersection->drain = 0;
     
-    printf("%s Initialized mutex for intersection %s (capacity 1)\n", getFakeTime(), intersection->name);
+    LOG_CONSOLE(LOG_LEVEL_DEBUG, "Initialized mutex for intersection %s (capacity 1)\n", intersection->name);
     return true;
 }
 
@@ -65,38 +70,68 @@ bool init_semaphore_lock(Intersection *intersection) {
         perror("Failed to initialize semaphore");
         return false;
     }
+    intersection->drain = 0;
     
-    printf("%s Initialized semaphore for intersection %s (capacity %d)\n",getFakeTime(), intersection->name, intersection->capacity);
+    LOG_CONSOLE(LOG_LEVEL_DEBUG, "Initialized semaphore for intersection %s (capacity %d)\n", intersection->name, intersection->capacity);
     return true;
 }
 
 // Acquire a lock for an intersection
 int acquire_lock(Intersection *intersection) {
+    return acquire_lock_timed(intersection, -1);
+}
+
+// Acquire a lock for an intersection with a deadline, or without one if timeout_ms < 0
+int acquire_lock_timed(Intersection *intersection, int timeout_ms) {
     if (!intersection) {
         fprintf(stderr, "Invalid intersection pointer\n");
         return -1;
     }
-    
+
+    // both timedlock and timedwait take an absolute CLOCK_REALTIME deadline
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
     int result = 0;
     setFakeSec(1);
     if (intersection->capacity == 1) {
         // For capacity 1 use mutex
-        result = pthread_mutex_lock(&intersection->mutex);
+        result = timeout_ms >= 0 ? pthread_mutex_timedlock(&intersection->mutex, &deadline)
+                                 : pthread_mutex_lock(&intersection->mutex);
+        if (result == ETIMEDOUT) {
+            RAIL_PROBE3(lock_acquire, intersection->name, intersection->capacity, 1);
+            return 1;
+        }
         if (result != 0) {
             perror("Failed to acquire mutex lock");
             return -1;
         }
-        printf("%s Acquired mutex lock for intersection %s\n", getFakeTime(), intersection->name);
+        LOG_CONSOLE(LOG_LEVEL_DEBUG, "Acquired mutex lock for intersection %s\n", intersection->name);
     } else {
-        // For capacity > 1 use semaphore
-        result = sem_wait(intersection->semaphore);
+        // For capacity > 1 use semaphore, retry if a signal interrupts the wait
+        while ((result = timeout_ms >= 0 ? sem_timedwait(intersection->semaphore, &deadline)
+                                         : sem_wait(intersection->semaphore)) != 0 && errno == EINTR)
+            ;
+        if (result != 0 && errno == ETIMEDOUT) {
+            RAIL_PROBE3(lock_acquire, intersection->name, intersection->capacity, 1);
+            return 1;
+        }
         if (result != 0) {
             perror("Failed to acquire semaphore lock");
             return -1;
         }
-        printf("%s Acquired semaphore lock for intersection %s\n", getFakeTime(), intersection->name);
+        LOG_CONSOLE(LOG_LEVEL_DEBUG, "Acquired semaphore lock for intersection %s\n", intersection->name);
     }
-    
+
+    RAIL_PROBE3(lock_acquire, intersection->name, intersection->capacity, 0);
     return 0;
 }
 
@@ -110,7 +145,12 @@ int release_lock(Intersection *intersection) {
     int result = 0;
     setFakeSec(1);
     
-    if (intersection->capacity == 1) {
+    if (intersection->drain > 0) {
+        // a holder from before the capacity was lowered, its slot no longer exists
+        intersection->drain--;
+        setFakeSec(1);
+        LOG_CONSOLE(LOG_LEVEL_DEBUG, "Released %s over capacity, %d still draining\n", intersection->name, intersection->drain);
+    } else if (intersection->capacity == 1) {
         // For capacity 1 use mutex
         result = pthread_mutex_unlock(&intersection->mutex);
         if (result != 0) {
@@ -118,7 +158,7 @@ int release_lock(Intersection *intersection) {
             return -1;
         }
         setFakeSec(1); // Increment time by 1 second
-        printf("%s Released mutex lock for intersection %s\n", getFakeTime(), intersection->name);
+        LOG_CONSOLE(LOG_LEVEL_DEBUG, "Released mutex lock for intersection %s\n", intersection->name);
     } else {
         // For capacity > 1 use semaphore
         result = sem_post(intersection->semaphore);
@@ -127,9 +167,46 @@ int release_lock(Intersection *intersection) {
             return -1;
         }
         setFakeSec(1);
-        printf("%s Released semaphore lock for intersection %s\n", getFakeTime(), intersection->name);
+        LOG_CONSOLE(LOG_LEVEL_DEBUG, "Released semaphore lock for intersection %s\n", intersection->name);
     }
     
+    RAIL_PROBE2(lock_release, intersection->name, intersection->capacity);
+    return 0;
+}
+
+// Resize a lock. Only the server takes these locks, so it owns every slot that is
+// taken: the old lock is emptied and destroyed, a new one is made for the new capacity
+// (a mutex for 1, a semaphore above), and the new one is taken once per holder it has
+// room for. Holders past the new capacity go in drain; their releases free nothing,
+// so a lowered intersection admits no one until it is under its new capacity.
+int resize_lock(Intersection *intersection, int capacity, int held) {
+    if (!intersection || capacity <= 0 || held < 0) {
+        fprintf(stderr, "Invalid intersection or capacity\n");
+        return -1;
+    }
+
+    if (intersection->capacity == 1 && held > intersection->drain) {
+        pthread_mutex_unlock(&intersection->mutex);
+    }
+    cleanup_locks(intersection);
+    intersection->capacity = capacity;
+    bool ok = capacity == 1 ? init_mutex_lock(intersection) : init_semaphore_lock(intersection);
+    if (!ok) {
+        return -1;
+    }
+
+    int keep = held < capacity ? held : capacity;
+    for (int i = 0; i < keep; i++) {
+        int result = capacity == 1 ? pthread_mutex_trylock(&intersection->mutex)
+                                   : sem_trywait(intersection->semaphore);
+        if (result != 0) {
+            perror("Failed to retake lock after resize");
+            return -1;
+        }
+    }
+    intersection->drain = held - keep;
+    LOG_CONSOLE(LOG_LEVEL_DEBUG, "Resized lock for intersection %s to capacity %d (%d held, %d draining)\n",
+                intersection->name, capacity, held, intersection->drain);
     return 0;
 }
 
@@ -148,5 +225,5 @@ void cleanup_locks(Intersection *intersection) {
         sem_unlink(intersection->semName);
     }
     
-    printf("Cleaned up locks for intersection %s\n", intersection->name);
+    LOG_CONSOLE(LOG_LEVEL_DEBUG, "Cleaned up locks for intersection %s\n", intersection->name);
 }
@@ -28,6 +28,7 @@ typedef struct {
     pthread_mutex_t mutex;           // Mutex (capacity = 1)
     sem_t *semaphore;                // Semaphore (capacity > 1)
     char semName[MAX_NAME_LENGTH];   // Unique name for semaphore
+    int drain;                       // holders past a lowered capacity, their releases free no slot
 } Intersection;
 
 // GLOBAL SHARED INTERSECTIONS ARRAY
@@ -45,10 +46,18 @@ bool init_semaphore_lock(Intersection *intersection);
 // Returns 0 on success, -1 on failure
 int acquire_lock(Intersection *intersection);
 
+// Acquire a lock for an intersection, giving up after timeout_ms (never if it is < 0)
+// Returns 0 on success, 1 if the timeout expired, -1 on failure
+int acquire_lock_timed(Intersection *intersection, int timeout_ms);
+
 // Release a lock for an intersection
 // Returns 0 on success, -1 on failure
 int release_lock(Intersection *intersection);
 
+// Rebuild the lock for a new capacity while held trains keep their places.
+// held is how many trains hold the intersection now. Returns 0 on success, -1 on failure
+int resize_lock(Intersection *intersection, int capacity, int held);
+
 // Clean up an intersection's locks
 void cleanup_locks(Intersection *intersection);
 
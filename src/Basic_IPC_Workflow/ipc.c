@@ -23,6 +23,7 @@ LOG_CSV(0, "SYSTEM", "INIT_INTERSECTION", "SUCCESS", getpid(), NULL, NULL, NULL,
 // and the action ("ACQUIRE" or "RELEASE")
 void send_message(int msgid, int train_id, const char* intersection, const char* action) {
     Message msg;
+    memset(&msg, 0, sizeof(msg));
 
     msg.mtype = 1;  // All messages have type 1; can be expanded later for prioritization
     msg.train_id = train_id; // Set the sender train's ID
@@ -41,4 +42,25 @@ void send_message(int msgid, int train_id, const char* intersection, const char*
     }
 }
 
+// Sends an ACQ_SET request. The server grants every intersection in names[]
+// together (taking them in its global order) or queues the whole set.
+void send_set_message(int msgid, int train_id, const char *names[], int count, int timeout_ms) {
+    Message msg;
+    memset(&msg, 0, sizeof(msg));
+
+    if (count > MAX_WINDOW) count = MAX_WINDOW;
+
+    msg.mtype = 1;
+    msg.train_id = train_id;
+    strncpy(msg.intersection, names[0], MAX_NAME - 1);
+    snprintf(msg.action, sizeof(msg.action), "ACQ_SET");
+    msg.set_count = count;
+    msg.timeout_ms = timeout_ms;
+    for (int i = 0; i < count; i++) {
+        strncpy(msg.set[i], names[i], MAX_NAME - 1);
+    }
 
+    if (msgsnd(msgid, &msg, sizeof(Message) - sizeof(long), 0) == -1) {
+        perror("msgsnd failed");
+    }
+}
@@ -9,15 +9,23 @@
 
 #define MAX_NAME 64
 #define MSG_KEY 1234
+#define MAX_WINDOW 4 // most intersections one ACQ_SET can ask for
 
 typedef struct {
     long mtype;// required for System V message queues
     int train_id;
     char intersection[MAX_NAME];
-    char action[8];// "ACQUIRE" or "RELEASE"
+    char action[8];// "ACQUIRE", "RELEASE" or "ACQ_SET"; replies "GRANT", "WAIT", "OK", "FAIL", "TIMEOUT"
+    int timeout_ms;// ACQUIRE/ACQ_SET: give up after this long in the wait queue, 0 waits forever
+    int set_count;// ACQ_SET only: number of names in set[]
+    char set[MAX_WINDOW][MAX_NAME];// ACQ_SET only: intersections granted together or not at all
 } Message;
 
 // Send an ACQUIRE or RELEASE message to the server
 void send_message(int msgid, int train_id, const char* intersection, const char* action);
 
+// Send an ACQ_SET message asking for all of names[0..count-1] at once.
+// timeout_ms > 0 makes the server answer TIMEOUT if the set is not granted in time
+void send_set_message(int msgid, int train_id, const char *names[], int count, int timeout_ms);
+
 #endif
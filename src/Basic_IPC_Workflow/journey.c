@@ -0,0 +1,173 @@
+// journey.c
+// Group: B
+// Date: 10-19-2026
+// Per-hop time accounting for trains, see journey.h. Every child writes only its own
+// slot, and the parent reads after waitpid(), so the table needs no locking.
+#include "journey.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h" // fake clock, LatencyHistogram
+
+// one mapping: this header, then the trains, then every train's hops back to back
+typedef struct {
+    int max_trains;
+    int max_hops;
+    int dropped_trains;             // children past max_trains, counted atomically
+    int dropped_hops;               // hops past max_hops, over all trains
+    JourneyTrain trains[];
+} JourneyTable;
+
+static JourneyTable *table = NULL;
+static size_t table_size = 0;
+
+static const char *phase_names[JOURNEY_PHASES] = { "queued", "capacity", "traverse", "ack" };
+
+int journey_create(int trains, int hops) {
+    if (trains < 1) trains = 1;
+    if (hops < 1) hops = 1;
+    size_t hops_offset = sizeof(JourneyTable) + (size_t)trains * sizeof(JourneyTrain);
+    hops_offset = (hops_offset + 63) & ~(size_t)63;
+    table_size = hops_offset + (size_t)trains * hops * sizeof(JourneyHop);
+    // anonymous pages are zero and only backed once touched, so unused slots are free
+    table = mmap(NULL, table_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (table == MAP_FAILED) {
+        perror("journey mmap");
+        table = NULL;
+        return -1;
+    }
+    table->max_trains = trains;
+    table->max_hops = hops;
+    // the children inherit the mapping at the same address, so the pointers hold for them
+    JourneyHop *all_hops = (JourneyHop *)((char *)table + hops_offset);
+    for (int t = 0; t < trains; t++) table->trains[t].hops = all_hops + (size_t)t * hops;
+    return 0;
+}
+
+void journey_destroy(void) {
+    if (table) munmap(table, table_size);
+    table = NULL;
+}
+
+JourneyTrain *journey_claim(int slot, int train_id) {
+    if (!table || slot < 0) return NULL;
+    if (slot >= table->max_trains) {
+        __atomic_fetch_add(&table->dropped_trains, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    JourneyTrain *train = &table->trains[slot];
+    train->train_id = train_id;
+    train->hop_count = 0;
+    return train;
+}
+
+JourneyHop *journey_next_hop(JourneyTrain *train, const char *intersection) {
+    if (!train) return NULL;
+    if (train->hop_count >= table->max_hops) {
+        __atomic_fetch_add(&table->dropped_hops, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    JourneyHop *hop = &train->hops[train->hop_count++];
+    snprintf(hop->intersection, sizeof(hop->intersection), "%s", intersection);
+    return hop;
+}
+
+JourneyStamp journey_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    JourneyStamp now;
+    now.wall_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    now.sim_s = shared_intersections ? __atomic_load_n(&shared_intersections[0].fakeSec, __ATOMIC_RELAXED) : 0;
+    return now;
+}
+
+void journey_add(JourneyHop *hop, int phase, JourneyStamp *since) {
+    JourneyStamp now = journey_now();
+    if (hop) {
+        hop->wall_ns[phase] += now.wall_ns - since->wall_ns;
+        hop->sim_s[phase] += now.sim_s - since->sim_s;
+    }
+    *since = now;
+}
+
+static uint64_t hop_wall(const JourneyHop *hop) {
+    uint64_t total = 0;
+    for (int p = 0; p < JOURNEY_PHASES; p++) total += hop->wall_ns[p];
+    return total;
+}
+
+static void print_phases_header(FILE *out, const char *first, const char *second) {
+    fprintf(out, "%-8s %-16s", first, second);
+    for (int p = 0; p < JOURNEY_PHASES; p++) fprintf(out, " %10s", phase_names[p]);
+    fprintf(out, " %10s   sim s (q/c/t/a)\n", "total");
+}
+
+void journey_report(FILE *out) {
+    if (!table) return;
+
+    // per train totals; the slowest train is the critical path of the whole run
+    fprintf(out, "\nJourney per train, wall ms:\n");
+    print_phases_header(out, "train", "hops");
+    int slowest = -1;
+    uint64_t slowest_total = 0;
+    static LatencyHistogram wall[JOURNEY_PHASES], sim[JOURNEY_PHASES];
+    memset(wall, 0, sizeof(wall));
+    memset(sim, 0, sizeof(sim));
+    for (int t = 0; t < table->max_trains; t++) {
+        const JourneyTrain *train = &table->trains[t];
+        if (train->train_id == 0) continue;
+        uint64_t sum_wall[JOURNEY_PHASES] = { 0 };
+        int sum_sim[JOURNEY_PHASES] = { 0 };
+        uint64_t total = 0;
+        for (int h = 0; h < train->hop_count; h++) {
+            const JourneyHop *hop = &train->hops[h];
+            for (int p = 0; p < JOURNEY_PHASES; p++) {
+                sum_wall[p] += hop->wall_ns[p];
+                sum_sim[p] += hop->sim_s[p];
+                hist_record(&wall[p], hop->wall_ns[p]);
+                hist_record(&sim[p], (uint64_t)(hop->sim_s[p] > 0 ? hop->sim_s[p] : 0));
+            }
+            total += hop_wall(hop);
+        }
+        char label[16];
+        snprintf(label, sizeof(label), "Train%d", train->train_id);
+        fprintf(out, "%-8s %-16d", label, train->hop_count);
+        for (int p = 0; p < JOURNEY_PHASES; p++) fprintf(out, " %10.1f", sum_wall[p] / 1e6);
+        fprintf(out, " %10.1f   %d/%d/%d/%d\n", total / 1e6,
+                sum_sim[JOURNEY_QUEUED], sum_sim[JOURNEY_CAPACITY], sum_sim[JOURNEY_TRAVERSE], sum_sim[JOURNEY_ACK]);
+        if (slowest < 0 || total > slowest_total) {
+            slowest = t;
+            slowest_total = total;
+        }
+    }
+    if (table->dropped_trains || table->dropped_hops) {
+        fprintf(out, "(not recorded: %d trains past the first %d, %d hops past %d in a train)\n",
+                table->dropped_trains, table->max_trains, table->dropped_hops, table->max_hops);
+    }
+    if (slowest < 0) {
+        fprintf(out, "(no trains recorded)\n");
+        return;
+    }
+
+    const JourneyTrain *train = &table->trains[slowest];
+    fprintf(out, "\nCritical path (Train%d, the slowest), wall ms per hop:\n", train->train_id);
+    print_phases_header(out, "hop", "intersection");
+    for (int h = 0; h < train->hop_count; h++) {
+        const JourneyHop *hop = &train->hops[h];
+        fprintf(out, "%-8d %-16s", h + 1, hop->intersection);
+        for (int p = 0; p < JOURNEY_PHASES; p++) fprintf(out, " %10.1f", hop->wall_ns[p] / 1e6);
+        fprintf(out, " %10.1f   %d/%d/%d/%d\n", hop_wall(hop) / 1e6, hop->sim_s[JOURNEY_QUEUED],
+                hop->sim_s[JOURNEY_CAPACITY], hop->sim_s[JOURNEY_TRAVERSE], hop->sim_s[JOURNEY_ACK]);
+    }
+
+    fprintf(out, "\nFleet, every hop (wall ms | sim s):\n");
+    fprintf(out, "%-10s %8s %10s %10s %10s %10s   %5s %5s %5s\n", "phase", "hops", "p50", "p90", "p99", "max",
+            "p50", "p99", "max");
+    for (int p = 0; p < JOURNEY_PHASES; p++) {
+        fprintf(out, "%-10s %8llu %10.2f %10.2f %10.2f %10.2f   %5llu %5llu %5llu\n", phase_names[p],
+                (unsigned long long)wall[p].count, stats_percentile(&wall[p], 0.50) / 1e6,
+                stats_percentile(&wall[p], 0.90) / 1e6, stats_percentile(&wall[p], 0.99) / 1e6,
+                wall[p].max_ns / 1e6, (unsigned long long)stats_percentile(&sim[p], 0.50),
+                (unsigned long long)stats_percentile(&sim[p], 0.99), (unsigned long long)sim[p].max_ns);
+    }
+}
@@ -0,0 +1,69 @@
+// journey.h
+// Group: B
+// Date: 10-19-2026
+// Where each train's time goes. For every hop a train records, in wall time and in
+// sim seconds:
+//   queued    ACQUIRE (or ACQ_SET) sent -> first reply, i.e. the message queue and server
+//   capacity  first reply -> GRANT: WAIT time, plus timeouts and backoff before a retry
+//   traverse  GRANT (or the previous release) -> RELEASE sent
+//   ack       RELEASE sent -> OK received
+// The table lives in an anonymous shared mapping the train simulator creates before
+// it forks, so each child writes its own slot and the parent reads them all after
+// waitpid() without parsing any log. It is sized for the fleet when the fleet is known,
+// and reserved without backing for a stream, so slots that are never used cost nothing.
+#ifndef JOURNEY_H
+#define JOURNEY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define JOURNEY_STREAM_TRAINS 4096  // table size for a stream, whose fleet is not known up front
+#define JOURNEY_STREAM_HOPS   64
+#define JOURNEY_NAME_LEN      32
+
+enum {
+    JOURNEY_QUEUED = 0,
+    JOURNEY_CAPACITY,
+    JOURNEY_TRAVERSE,
+    JOURNEY_ACK,
+    JOURNEY_PHASES
+};
+
+typedef struct {
+    char intersection[JOURNEY_NAME_LEN];
+    uint64_t wall_ns[JOURNEY_PHASES];
+    int sim_s[JOURNEY_PHASES];
+} JourneyHop;
+
+typedef struct {
+    int train_id;                   // 0 = slot unused
+    int hop_count;
+    JourneyHop *hops;               // room for the table's hops per train
+} JourneyTrain;
+
+// a point in time on both clocks
+typedef struct {
+    uint64_t wall_ns;
+    int sim_s;
+} JourneyStamp;
+
+// parent, before forking: room for trains trains of up to hops hops each. Trains and
+// hops past that are counted and the report says how many were left out.
+// Returns 0, or -1 and the report is skipped
+int  journey_create(int trains, int hops);
+void journey_destroy(void);
+
+// child: its own slot (NULL if there is no table or slot is out of range)
+JourneyTrain *journey_claim(int slot, int train_id);
+// starts the next hop of the train, NULL when there is no room (calls below accept NULL)
+JourneyHop *journey_next_hop(JourneyTrain *train, const char *intersection);
+
+JourneyStamp journey_now(void);
+// charges the time since *since to one phase of hop and moves *since to now
+void journey_add(JourneyHop *hop, int phase, JourneyStamp *since);
+
+// parent, after every child has exited: per-train totals, the hops of the slowest
+// train, and percentiles of each phase over every hop of the fleet
+void journey_report(FILE *out);
+
+#endif // JOURNEY_H
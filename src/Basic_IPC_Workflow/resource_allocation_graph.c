@@ -7,9 +7,11 @@
 // and intersection resources. The graph is used to detect circular wait conditions (deadlocks) 
 // via depth-first search (DFS). Nodes represent trains and intersections, and edges represent 
 // request and allocation states.
+// 10-19-2026: DFS is iterative, print_deadlocked_sets() lists every deadlocked set (scc_analysis.c)
 #include <stdio.h>
 #include <string.h>
 #include "resource_allocation_graph.h"
+#include "scc_analysis.h"
 #include "../logger/csv_logger.h" // For logging
 
 #define NAME_LEN 64
@@ -79,24 +81,82 @@ bool detect_deadlock() {
     return false;
 }
 
-// DFS for cycle detection
-static bool dfs(int v, bool* visited, bool* rec_stack) {
-    visited[v] = true;
-    rec_stack[v] = true;
-
-    for (int u = 0; u < node_count; u++) {
-        if (adj[v][u]) {
-            if (!visited[u] && dfs(u, visited, rec_stack))
-                return true;
-            else if (rec_stack[u])
-                return true;
+// DFS for cycle detection. Iterative with an explicit stack so a long chain of
+// waits can't overflow the call stack
+static bool dfs(int root, bool* visited, bool* rec_stack) {
+    int stack[MAX_NODES]; // nodes on the current path
+    int next[MAX_NODES];  // next neighbor to look at for each of them
+    int top = 0;
+
+    stack[0] = root;
+    next[0] = 0;
+    visited[root] = true;
+    rec_stack[root] = true;
+
+    while (top >= 0) {
+        int v = stack[top];
+        int u = next[top]++;
+        if (u >= node_count) {
+            rec_stack[v] = false; // done with v
+            top--;
+            continue;
+        }
+        if (!adj[v][u])
+            continue;
+        if (rec_stack[u])
+            return true; // back edge
+        if (!visited[u]) {
+            visited[u] = true;
+            rec_stack[u] = true;
+            stack[++top] = u;
+            next[top] = 0;
         }
     }
-
-    rec_stack[v] = false;
     return false;
 }
 
+// Finds every deadlocked set at once (each strongly connected component with a cycle)
+// and prints its trains and intersections. Returns the number of sets, -1 if out of memory
+int print_deadlocked_sets() {
+    int from[MAX_NODES * MAX_NODES], to[MAX_NODES * MAX_NODES];
+    int edges = 0;
+    for (int i = 0; i < node_count; i++) {
+        for (int j = 0; j < node_count; j++) {
+            if (adj[i][j]) {
+                from[edges] = i;
+                to[edges++] = j;
+            }
+        }
+    }
+
+    SccGraph g;
+    int comp[MAX_NODES];
+    char deadlocked[MAX_NODES];
+    if (scc_graph_build(&g, node_count, from, to, edges) != 0)
+        return -1;
+    int comp_count = scc_components(&g, 1, comp);
+    if (comp_count < 0) {
+        fprintf(stderr, "print_deadlocked_sets: out of memory\n");
+        scc_graph_free(&g);
+        return -1;
+    }
+    int sets = scc_deadlocked_sets(&g, comp, comp_count, deadlocked);
+
+    printf("Deadlocked sets: %d\n", sets);
+    for (int c = 0; c < comp_count; c++) {
+        if (!deadlocked[c])
+            continue;
+        printf(" ");
+        for (int v = 0; v < node_count; v++) {
+            if (comp[v] == c)
+                printf(" [%s]", nodes[v].name);
+        }
+        printf("\n");
+    }
+    scc_graph_free(&g);
+    return sets;
+}
+
 static int get_or_create_node(NodeType type, int id, const char* name) {
     int idx = find_node(type, id);
     if (idx >= 0) return idx; // Node already exists
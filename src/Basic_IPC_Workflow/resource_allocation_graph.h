@@ -26,6 +26,7 @@ void add_request_edge(int train_id, const char* intersection);
 void add_allocation_edge(int train_id, const char* intersection);
 void remove_edges(int train_id, const char* intersection);
 bool detect_deadlock();
+int print_deadlocked_sets();
 void print_graph();
 
 #endif
@@ -0,0 +1,437 @@
+// scc_analysis.c
+// Group: B
+// Date: 10-19-2026
+// Tarjan and parallel forward-backward SCC decomposition over CSR graphs. See scc_analysis.h.
+//
+// Forward-backward: pick a pivot in a vertex set, the nodes it reaches (FW) that also reach
+// it (BW) form its SCC. FW-only, BW-only and untouched nodes cannot share an SCC, so they
+// become three independent sets that idle threads pick up. Before each split, nodes with no
+// incoming or outgoing edge inside the set are trimmed off as single-node components, which
+// keeps long acyclic chains from degrading the split.
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "scc_analysis.h"
+
+int scc_graph_build(SccGraph *g, int node_count, const int from[], const int to[], int edge_count) {
+    g->node_count = node_count;
+    g->edge_count = edge_count;
+    g->offsets = calloc((size_t)node_count + 1, sizeof(int));
+    g->targets = malloc((size_t)(edge_count > 0 ? edge_count : 1) * sizeof(int));
+    if (!g->offsets || !g->targets) {
+        scc_graph_free(g);
+        return -1;
+    }
+
+    // counting sort of the edges by source node
+    for (int e = 0; e < edge_count; e++) g->offsets[from[e] + 1]++;
+    for (int v = 0; v < node_count; v++) g->offsets[v + 1] += g->offsets[v];
+    int *fill = malloc((size_t)(node_count > 0 ? node_count : 1) * sizeof(int));
+    if (!fill) {
+        scc_graph_free(g);
+        return -1;
+    }
+    memcpy(fill, g->offsets, (size_t)node_count * sizeof(int));
+    for (int e = 0; e < edge_count; e++) g->targets[fill[from[e]]++] = to[e];
+    free(fill);
+    return 0;
+}
+
+void scc_graph_free(SccGraph *g) {
+    free(g->offsets);
+    free(g->targets);
+    g->offsets = NULL;
+    g->targets = NULL;
+}
+
+// reversed copy of g, used for the backward searches
+static int reverse_graph(const SccGraph *g, SccGraph *r) {
+    int *from = malloc((size_t)(g->edge_count > 0 ? g->edge_count : 1) * sizeof(int));
+    if (!from) return -1;
+    for (int v = 0; v < g->node_count; v++) {
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) from[e] = v;
+    }
+    int rc = scc_graph_build(r, g->node_count, g->targets, from, g->edge_count);
+    free(from);
+    return rc;
+}
+
+// TARJAN (serial)
+
+static int tarjan(const SccGraph *g, int comp[]) {
+    int n = g->node_count;
+    int *index = malloc((size_t)n * sizeof(int));
+    int *low = malloc((size_t)n * sizeof(int));
+    int *stack = malloc((size_t)n * sizeof(int));     // Tarjan's node stack
+    int *frame_v = malloc((size_t)n * sizeof(int));   // explicit call stack: node
+    int *frame_e = malloc((size_t)n * sizeof(int));   // explicit call stack: next edge
+    char *on_stack = calloc((size_t)n, 1);
+    int comp_count = -1;
+    if (!index || !low || !stack || !frame_v || !frame_e || !on_stack) goto out;
+
+    for (int v = 0; v < n; v++) index[v] = -1;
+    int next_index = 0, sp = 0;
+    comp_count = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1) continue;
+        int fp = 0;
+        frame_v[0] = root;
+        frame_e[0] = g->offsets[root];
+        index[root] = low[root] = next_index++;
+        stack[sp++] = root;
+        on_stack[root] = 1;
+
+        while (fp >= 0) {
+            int v = frame_v[fp];
+            if (frame_e[fp] < g->offsets[v + 1]) {
+                int w = g->targets[frame_e[fp]++];
+                if (index[w] == -1) {
+                    // "recurse" into w
+                    index[w] = low[w] = next_index++;
+                    stack[sp++] = w;
+                    on_stack[w] = 1;
+                    fp++;
+                    frame_v[fp] = w;
+                    frame_e[fp] = g->offsets[w];
+                } else if (on_stack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            // all edges of v done: v roots an SCC if nothing below reached higher
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--sp];
+                    on_stack[w] = 0;
+                    comp[w] = comp_count;
+                } while (w != v);
+                comp_count++;
+            }
+            fp--;
+            if (fp >= 0 && low[v] < low[frame_v[fp]]) low[frame_v[fp]] = low[v];
+        }
+    }
+
+out:
+    free(index); free(low); free(stack); free(frame_v); free(frame_e); free(on_stack);
+    return comp_count;
+}
+
+// FORWARD-BACKWARD (parallel)
+
+typedef struct {
+    int *verts;
+    int n;
+    int label;
+} SccTask;
+
+typedef struct {
+    const SccGraph *g;
+    const SccGraph *r;
+    int *comp;
+    int *label;         // which task set a node is in, -1 once it has a component
+    int *fw, *bw;       // reach marks, stamped with the task label so they never need clearing
+    int *in_deg, *out_deg;
+    int next_label;
+    int next_comp;
+    int failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t more;
+    SccTask *tasks;
+    int task_count, task_cap;
+    int idle, threads, done;
+} FwBw;
+
+static void push_task(FwBw *s, int *verts, int n) {
+    if (n == 0) {
+        free(verts);
+        return;
+    }
+    int label = __atomic_fetch_add(&s->next_label, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < n; i++) __atomic_store_n(&s->label[verts[i]], label, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&s->lock);
+    if (s->task_count == s->task_cap) {
+        int cap = s->task_cap * 2;
+        SccTask *grown = realloc(s->tasks, (size_t)cap * sizeof(SccTask));
+        if (!grown) {
+            s->failed = 1;
+            pthread_mutex_unlock(&s->lock);
+            free(verts);
+            return;
+        }
+        s->tasks = grown;
+        s->task_cap = cap;
+    }
+    s->tasks[s->task_count++] = (SccTask){ verts, n, label };
+    pthread_cond_signal(&s->more);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static inline int in_set(FwBw *s, int v, int label) {
+    return __atomic_load_n(&s->label[v], __ATOMIC_RELAXED) == label;
+}
+
+// peels nodes with no in- or out-edge inside the set, returns the new size of verts
+static int trim(FwBw *s, SccTask *t, int *queue) {
+    const SccGraph *g = s->g, *r = s->r;
+    int head = 0, tail = 0;
+    for (int i = 0; i < t->n; i++) {
+        int v = t->verts[i];
+        int out = 0, in = 0;
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) out += in_set(s, g->targets[e], t->label);
+        for (int e = r->offsets[v]; e < r->offsets[v + 1]; e++) in += in_set(s, r->targets[e], t->label);
+        s->out_deg[v] = out;
+        s->in_deg[v] = in;
+        if (out == 0 || in == 0) queue[tail++] = v;
+    }
+    for (int i = 0; i < tail; i++) __atomic_store_n(&s->label[queue[i]], -2, __ATOMIC_RELAXED); // queued
+
+    while (head < tail) {
+        int v = queue[head++];
+        s->comp[v] = __atomic_fetch_add(&s->next_comp, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->label[v], -1, __ATOMIC_RELAXED);
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+            int u = g->targets[e];
+            if (in_set(s, u, t->label) && --s->in_deg[u] == 0) {
+                __atomic_store_n(&s->label[u], -2, __ATOMIC_RELAXED);
+                queue[tail++] = u;
+            }
+        }
+        for (int e = r->offsets[v]; e < r->offsets[v + 1]; e++) {
+            int u = r->targets[e];
+            if (in_set(s, u, t->label) && --s->out_deg[u] == 0) {
+                __atomic_store_n(&s->label[u], -2, __ATOMIC_RELAXED);
+                queue[tail++] = u;
+            }
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < t->n; i++) {
+        if (in_set(s, t->verts[i], t->label)) t->verts[kept++] = t->verts[i];
+    }
+    return kept;
+}
+
+// marks everything reachable from pivot inside the set, in g's direction
+static void reach(FwBw *s, const SccGraph *g, int *mark, int pivot, int label, int *queue) {
+    int head = 0, tail = 0;
+    mark[pivot] = label;
+    queue[tail++] = pivot;
+    while (head < tail) {
+        int v = queue[head++];
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+            int u = g->targets[e];
+            if (mark[u] != label && in_set(s, u, label)) {
+                mark[u] = label;
+                queue[tail++] = u;
+            }
+        }
+    }
+}
+
+static void split(FwBw *s, SccTask *t) {
+    int *queue = malloc((size_t)t->n * sizeof(int));
+    if (!queue) {
+        s->failed = 1;
+        free(t->verts);
+        return;
+    }
+
+    t->n = trim(s, t, queue);
+    if (t->n == 0) {
+        free(queue);
+        free(t->verts);
+        return;
+    }
+
+    int pivot = t->verts[0];
+    reach(s, s->g, s->fw, pivot, t->label, queue);
+    reach(s, s->r, s->bw, pivot, t->label, queue);
+    free(queue);
+
+    int scc = __atomic_fetch_add(&s->next_comp, 1, __ATOMIC_RELAXED);
+    int *fw_only = malloc((size_t)t->n * sizeof(int));
+    int *bw_only = malloc((size_t)t->n * sizeof(int));
+    int n_fw = 0, n_bw = 0, n_rest = 0;
+    if (!fw_only || !bw_only) {
+        s->failed = 1;
+        free(fw_only); free(bw_only); free(t->verts);
+        return;
+    }
+    for (int i = 0; i < t->n; i++) {
+        int v = t->verts[i];
+        int f = s->fw[v] == t->label, b = s->bw[v] == t->label;
+        if (f && b) {
+            s->comp[v] = scc;
+            __atomic_store_n(&s->label[v], -1, __ATOMIC_RELAXED);
+        } else if (f) {
+            fw_only[n_fw++] = v;
+        } else if (b) {
+            bw_only[n_bw++] = v;
+        } else {
+            t->verts[n_rest++] = v; // reuse the task's array for the untouched nodes
+        }
+    }
+    push_task(s, fw_only, n_fw);
+    push_task(s, bw_only, n_bw);
+    push_task(s, t->verts, n_rest);
+}
+
+static void *fwbw_worker(void *arg) {
+    FwBw *s = arg;
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        if (s->task_count > 0) {
+            SccTask t = s->tasks[--s->task_count];
+            pthread_mutex_unlock(&s->lock);
+            split(s, &t);
+            pthread_mutex_lock(&s->lock);
+            continue;
+        }
+        // nothing queued: finished once every thread is waiting
+        if (++s->idle == s->threads) {
+            s->done = 1;
+            pthread_cond_broadcast(&s->more);
+        }
+        while (s->task_count == 0 && !s->done) pthread_cond_wait(&s->more, &s->lock);
+        s->idle--;
+        if (s->done) break;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static int forward_backward(const SccGraph *g, int threads, int comp[]) {
+    int n = g->node_count;
+    FwBw s;
+    memset(&s, 0, sizeof(s));
+    SccGraph r = { 0 };
+    if (reverse_graph(g, &r) != 0) return -1;
+    s.g = g;
+    s.r = &r;
+    s.comp = comp;
+    s.threads = threads;
+    s.label = malloc((size_t)n * sizeof(int));
+    s.fw = malloc((size_t)n * sizeof(int));
+    s.bw = malloc((size_t)n * sizeof(int));
+    s.in_deg = malloc((size_t)n * sizeof(int));
+    s.out_deg = malloc((size_t)n * sizeof(int));
+    s.task_cap = 64;
+    s.tasks = malloc((size_t)s.task_cap * sizeof(SccTask));
+    int *all = malloc((size_t)n * sizeof(int));
+    pthread_t *ids = malloc((size_t)threads * sizeof(pthread_t));
+    int result = -1;
+    if (!s.label || !s.fw || !s.bw || !s.in_deg || !s.out_deg || !s.tasks || !all || !ids) {
+        free(all);
+        goto out;
+    }
+    for (int v = 0; v < n; v++) {
+        s.fw[v] = s.bw[v] = -1;
+        all[v] = v;
+    }
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.more, NULL);
+    push_task(&s, all, n);
+
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&ids[started], NULL, fwbw_worker, &s) != 0) break;
+    }
+    if (started == 0) {
+        // could not start any thread, do it on this one
+        s.threads = 1;
+        fwbw_worker(&s);
+    } else {
+        if (started < threads) {
+            pthread_mutex_lock(&s.lock);
+            s.threads = started;
+            if (s.idle == s.threads) {
+                s.done = 1;
+                pthread_cond_broadcast(&s.more);
+            }
+            pthread_mutex_unlock(&s.lock);
+        }
+        for (int i = 0; i < started; i++) pthread_join(ids[i], NULL);
+    }
+    pthread_mutex_destroy(&s.lock);
+    pthread_cond_destroy(&s.more);
+    if (!s.failed) result = s.next_comp;
+
+out:
+    free(s.label); free(s.fw); free(s.bw); free(s.in_deg); free(s.out_deg);
+    free(s.tasks); free(ids);
+    scc_graph_free(&r);
+    return result;
+}
+
+int scc_components(const SccGraph *g, int threads, int comp[]) {
+    if (g->node_count == 0) return 0;
+    if (threads <= 1) return tarjan(g, comp);
+    return forward_backward(g, threads, comp);
+}
+
+int scc_deadlocked_sets(const SccGraph *g, const int comp[], int comp_count, char deadlocked[]) {
+    int *size = calloc((size_t)(comp_count > 0 ? comp_count : 1), sizeof(int));
+    if (!size) return -1;
+    memset(deadlocked, 0, (size_t)comp_count);
+    for (int v = 0; v < g->node_count; v++) size[comp[v]]++;
+    for (int v = 0; v < g->node_count; v++) {
+        if (size[comp[v]] > 1) {
+            deadlocked[comp[v]] = 1;
+            continue;
+        }
+        // a single node is only stuck if it waits on itself
+        for (int e = g->offsets[v]; e < g->offsets[v + 1]; e++) {
+            if (g->targets[e] == v) deadlocked[comp[v]] = 1;
+        }
+    }
+    free(size);
+
+    int sets = 0;
+    for (int c = 0; c < comp_count; c++) sets += deadlocked[c];
+    return sets;
+}
+
+void scc_print_deadlocked_sets(FILE *out, const SccGraph *g, const int comp[], int comp_count,
+                               const long ids[]) {
+    char *deadlocked = malloc((size_t)(comp_count > 0 ? comp_count : 1));
+    int *start = calloc((size_t)comp_count + 1, sizeof(int));
+    int *members = malloc((size_t)(g->node_count > 0 ? g->node_count : 1) * sizeof(int));
+    if (!deadlocked || !start || !members) {
+        fprintf(out, "scc: out of memory\n");
+        goto out;
+    }
+    int sets = scc_deadlocked_sets(g, comp, comp_count, deadlocked);
+    fprintf(out, "%d deadlocked set(s)\n", sets);
+
+    // bucket the nodes of deadlocked components so each set prints in one line
+    for (int v = 0; v < g->node_count; v++) {
+        if (deadlocked[comp[v]]) start[comp[v] + 1]++;
+    }
+    for (int c = 0; c < comp_count; c++) start[c + 1] += start[c];
+    for (int v = 0; v < g->node_count; v++) {
+        if (deadlocked[comp[v]]) members[start[comp[v]]++] = v;
+    }
+
+    int set = 0, first = 0;
+    for (int c = 0; c < comp_count; c++) {
+        if (!deadlocked[c]) continue;
+        int end = start[c];
+        fprintf(out, "set %d (%d):", ++set, end - first);
+        for (int i = first; i < end; i++) {
+            if (ids) fprintf(out, " %ld", ids[members[i]]);
+            else fprintf(out, " %d", members[i]);
+        }
+        fprintf(out, "\n");
+        first = end;
+    }
+
+out:
+    free(deadlocked); free(start); free(members);
+}
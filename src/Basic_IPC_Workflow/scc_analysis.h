@@ -0,0 +1,40 @@
+// scc_analysis.h
+// Group: B
+// Date: 10-19-2026
+// Strongly connected component analysis for large train/intersection graphs. Every SCC with
+// more than one node (or a node waiting on itself) is a deadlocked set, so one pass finds all
+// of them instead of stopping at the first cycle like detect_deadlock(). Traversals are
+// iterative, so deep chains cannot overflow the stack. Serial runs use Tarjan's algorithm,
+// threaded runs use forward-backward decomposition with trimming.
+#ifndef SCC_ANALYSIS_H
+#define SCC_ANALYSIS_H
+
+#include <stdio.h>
+
+// Graph in compressed sparse row form: the edges leaving node v are
+// targets[offsets[v]] .. targets[offsets[v+1]-1]
+typedef struct {
+    int node_count;
+    int edge_count;
+    int *offsets;
+    int *targets;
+} SccGraph;
+
+// Builds g from an edge list of nodes 0..node_count-1. Returns 0 on success, -1 if out of memory
+int  scc_graph_build(SccGraph *g, int node_count, const int from[], const int to[], int edge_count);
+void scc_graph_free(SccGraph *g);
+
+// Labels every node with its component (comp[v]) and returns the number of components.
+// threads <= 1 runs Tarjan, otherwise forward-backward on that many threads.
+// Returns -1 if out of memory
+int  scc_components(const SccGraph *g, int threads, int comp[]);
+
+// Sets deadlocked[c] = 1 for every component c that is a deadlocked set and returns how many
+int  scc_deadlocked_sets(const SccGraph *g, const int comp[], int comp_count, char deadlocked[]);
+
+// Prints every deadlocked set and its members. ids[] maps nodes back to train/intersection
+// IDs; if it is NULL the node numbers are printed
+void scc_print_deadlocked_sets(FILE *out, const SccGraph *g, const int comp[], int comp_count,
+                               const long ids[]);
+
+#endif
@@ -41,5 +41,11 @@ int main() {
     }
 
     print_graph();
+
+    // List every deadlocked set (should be Train 1, A, Train 2, B)
+    if (print_deadlocked_sets() != 1) {
+        printf("Expected one deadlocked set\n");
+        return 1;
+    }
     return 0;
 }
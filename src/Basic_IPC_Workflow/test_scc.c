@@ -0,0 +1,119 @@
+// test_scc.c
+// Group: B
+// Date: 10-19-2026
+// Test program for scc_analysis. Checks that the parallel forward-backward pass finds the same
+// components as serial Tarjan on random wait graphs, that a million-node chain does not
+// overflow the stack, and prints timings for 1..8 threads on a large graph.
+// gcc -Wall -O2 -pthread -o test_scc test_scc.c scc_analysis.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "scc_analysis.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// random graph: mostly forward edges (acyclic waits) plus some back edges that close cycles
+static void random_graph(SccGraph *g, int n, int edges, int back_every, unsigned seed) {
+    int *from = malloc(edges * sizeof(int));
+    int *to = malloc(edges * sizeof(int));
+    srand(seed);
+    for (int e = 0; e < edges; e++) {
+        int a = rand() % n;
+        int b = rand() % n;
+        if (e % back_every != 0 && a > b) { int t = a; a = b; b = t; }
+        from[e] = a;
+        to[e] = b;
+    }
+    scc_graph_build(g, n, from, to, edges);
+    free(from);
+    free(to);
+}
+
+// same partition: nodes share a component in one labelling exactly when they do in the other
+static int same_partition(const int *a, const int *b, int n, int comps) {
+    int *map = malloc(comps * sizeof(int));
+    int *back = malloc(comps * sizeof(int));
+    for (int c = 0; c < comps; c++) map[c] = back[c] = -1;
+    int ok = 1;
+    for (int v = 0; v < n && ok; v++) {
+        if (map[a[v]] == -1 && back[b[v]] == -1) {
+            map[a[v]] = b[v];
+            back[b[v]] = a[v];
+        }
+        ok = map[a[v]] == b[v] && back[b[v]] == a[v];
+    }
+    free(map);
+    free(back);
+    return ok;
+}
+
+int main() {
+    // correctness against Tarjan
+    for (unsigned seed = 1; seed <= 50; seed++) {
+        SccGraph g;
+        int n = 50 + seed * 37;
+        random_graph(&g, n, n * 2, 3 + seed % 20, seed);
+        int *ref = malloc(n * sizeof(int));
+        int *par = malloc(n * sizeof(int));
+        int ref_count = scc_components(&g, 1, ref);
+        int threads = 1 + seed % 8;
+        int par_count = scc_components(&g, threads > 1 ? threads : 2, par);
+        if (ref_count != par_count || !same_partition(ref, par, n, ref_count)) {
+            printf("Seed %u: components differ (%d vs %d) — test failed\n", seed, ref_count, par_count);
+            return 1;
+        }
+        free(ref);
+        free(par);
+        scc_graph_free(&g);
+    }
+    printf("Parallel components match Tarjan on 50 random graphs\n");
+
+    // one long chain closed into a single cycle: recursion would need a million frames
+    {
+        int n = 1000000;
+        int *from = malloc(n * sizeof(int));
+        int *to = malloc(n * sizeof(int));
+        for (int v = 0; v < n; v++) {
+            from[v] = v;
+            to[v] = (v + 1) % n;
+        }
+        SccGraph g;
+        scc_graph_build(&g, n, from, to, n);
+        int *comp = malloc(n * sizeof(int));
+        char deadlocked[1];
+        for (int threads = 1; threads <= 4; threads *= 4) {
+            int c = scc_components(&g, threads, comp);
+            if (c != 1 || scc_deadlocked_sets(&g, comp, c, deadlocked) != 1) {
+                printf("Chain of %d not one deadlocked set — test failed\n", n);
+                return 1;
+            }
+        }
+        printf("Chain of %d trains is one deadlocked set\n", n);
+        free(from); free(to); free(comp);
+        scc_graph_free(&g);
+    }
+
+    // timings
+    {
+        int n = 2000000;
+        SccGraph g;
+        random_graph(&g, n, n * 3, 50, 7);
+        int *comp = malloc(n * sizeof(int));
+        char *deadlocked = malloc(n);
+        for (int threads = 1; threads <= 8; threads *= 2) {
+            double t0 = now();
+            int c = scc_components(&g, threads, comp);
+            double t1 = now();
+            int sets = scc_deadlocked_sets(&g, comp, c, deadlocked);
+            printf("%d nodes, %d threads: %d components, %d deadlocked sets, %.3f s\n",
+                   n, threads, c, sets, t1 - t0);
+        }
+        free(comp); free(deadlocked);
+        scc_graph_free(&g);
+    }
+    return 0;
+}
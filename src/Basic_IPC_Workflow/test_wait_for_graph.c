@@ -0,0 +1,48 @@
+// test_wait_for_graph.c
+// Group: B
+// Date: 10-19-2026
+// Test program for the wait-for graph snapshot. Builds the Train1/Train2 circular wait
+// from test_rag.c directly in a SharedIntersection array, checks that the snapshot finds
+// the cycle, then breaks it and checks again.
+// gcc -Wall -pthread -o test_wfg test_wait_for_graph.c wait_for_graph.c ../Shared_Memory_Setup/Memory_Segments.c ../Shared_Memory_Setup/latency_stats.c -lrt
+#include <stdio.h>
+#include <stdlib.h>
+#include "wait_for_graph.h"
+
+int main() {
+    // a whole segment, the lock wrappers read the stats region after the array
+    SharedIntersection *shared = calloc(1, SHM_SEGMENT_SIZE);
+    for (int i = 0; i < NUM_INTERSECTIONS; i++) {
+        pthread_mutex_init(&shared[i].mutex, NULL);
+        shared[i].capacity = 1;
+    }
+    static WaitForGraph g;
+
+    // Train 1 holds A, Train 2 holds B
+    add_holder(shared, 0, 1);
+    add_holder(shared, 1, 2);
+    // Train 2 waits for A, Train 1 waits for B
+    enqueue_waiter(shared, 0, 2);
+    enqueue_waiter(shared, 1, 1);
+
+    wfg_snapshot(shared, NUM_INTERSECTIONS, &g);
+    wfg_export(&g, stdout);
+
+    int cycle[MAX_TRAINS];
+    int len = 0;
+    if (!wfg_find_cycle(&g, cycle, &len) || len != 2) {
+        printf("Cycle not found — test failed\n");
+        return 1;
+    }
+    printf("Deadlock detected: Train %d -> Train %d\n", cycle[0], cycle[1]);
+
+    // Train 1 gives up B's wait
+    dequeue_waiter(shared, 1);
+    wfg_snapshot(shared, NUM_INTERSECTIONS, &g);
+    if (wfg_find_cycle(&g, cycle, &len)) {
+        printf("Still in deadlock — test failed.\n");
+        return 1;
+    }
+    printf("No deadlock after Train 1 stops waiting.\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+// wait_for_graph.c
+// Group: B
+// Date: 10-19-2026
+// Builds a trains-only wait-for graph from versioned (seqlock) reads of the shared
+// intersections and checks it for cycles. See wait_for_graph.h.
+#include <string.h>
+#include "wait_for_graph.h"
+
+#define WFG_MAX_NODES (NUM_INTERSECTIONS * MAX_TRAINS * 2)
+
+int wfg_snapshot(const SharedIntersection *shared, int count, WaitForGraph *g) {
+    memset(g, 0, sizeof(*g));
+    if (count > NUM_INTERSECTIONS) count = NUM_INTERSECTIONS;
+    g->intersection_count = count;
+    g->sim_sec = __atomic_load_n(&shared[0].fakeSec, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < count; i++) {
+        IntersectionSnapshot snap;
+        if (!snapshot_intersection(shared, i, &snap)) {
+            g->stale++;
+            continue;
+        }
+        // every waiter waits on every current holder
+        for (int w = 0; w < snap.wait_count; w++) {
+            for (int h = 0; h < snap.held_count; h++) {
+                if (g->edge_count >= WFG_MAX_EDGES) return g->edge_count;
+                WaitEdge *e = &g->edges[g->edge_count++];
+                e->waiter = snap.wait_queue[w];
+                e->holder = snap.holders[h];
+                e->intersection = i;
+            }
+        }
+    }
+    return g->edge_count;
+}
+
+// maps a train ID to a node index, adding it if new
+static int node_of(int ids[], int *n, int train_id) {
+    for (int i = 0; i < *n; i++) {
+        if (ids[i] == train_id) return i;
+    }
+    ids[*n] = train_id;
+    return (*n)++;
+}
+
+bool wfg_find_cycle(const WaitForGraph *g, int cycle[], int *cycle_len) {
+    int ids[WFG_MAX_NODES];
+    int n = 0;
+    int from[WFG_MAX_EDGES], to[WFG_MAX_EDGES];
+    for (int e = 0; e < g->edge_count; e++) {
+        from[e] = node_of(ids, &n, g->edges[e].waiter);
+        to[e] = node_of(ids, &n, g->edges[e].holder);
+    }
+
+    // iterative DFS: 0 = unvisited, 1 = on the current path, 2 = done
+    int color[WFG_MAX_NODES] = { 0 };
+    int stack[WFG_MAX_NODES];   // node on the path
+    int next[WFG_MAX_NODES];    // next edge to look at for that node
+    for (int root = 0; root < n; root++) {
+        if (color[root]) continue;
+        int top = 0;
+        stack[0] = root;
+        next[0] = 0;
+        color[root] = 1;
+        while (top >= 0) {
+            int v = stack[top];
+            int e = next[top]++;
+            if (e >= g->edge_count) {
+                color[v] = 2;
+                top--;
+                continue;
+            }
+            if (from[e] != v) continue;
+            int u = to[e];
+            if (color[u] == 0) {
+                color[u] = 1;
+                stack[++top] = u;
+                next[top] = 0;
+            } else if (color[u] == 1) {
+                // back edge: the path from u to v is the cycle
+                if (cycle && cycle_len) {
+                    int start = 0;
+                    while (stack[start] != u) start++;
+                    *cycle_len = 0;
+                    for (int k = start; k <= top && *cycle_len < MAX_TRAINS; k++) {
+                        cycle[(*cycle_len)++] = ids[stack[k]];
+                    }
+                }
+                return true;
+            }
+        }
+    }
+    if (cycle_len) *cycle_len = 0;
+    return false;
+}
+
+void wfg_export(const WaitForGraph *g, FILE *out) {
+    fprintf(out, "# wait-for graph sim_sec=%d intersections=%d stale=%d edges=%d\n",
+            g->sim_sec, g->intersection_count, g->stale, g->edge_count);
+    fprintf(out, "# waiter holder intersection\n");
+    for (int e = 0; e < g->edge_count; e++) {
+        fprintf(out, "%d %d %d\n", g->edges[e].waiter, g->edges[e].holder,
+                g->edges[e].intersection);
+    }
+}
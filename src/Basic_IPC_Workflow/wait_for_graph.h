@@ -0,0 +1,42 @@
+// wait_for_graph.h
+// Group: B
+// Date: 10-19-2026
+// Trains-only wait-for graph built from the shared memory segment. A train that sits in an
+// intersection's wait queue waits for every train holding that intersection. The snapshot
+// uses the seqlock reads in Memory_Segments.c, so it never takes a SharedIntersection mutex
+// and can be taken from a monitor process while the server keeps admitting trains.
+#ifndef WAIT_FOR_GRAPH_H
+#define WAIT_FOR_GRAPH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+
+#define WFG_MAX_EDGES (NUM_INTERSECTIONS * MAX_TRAINS * MAX_TRAINS)
+
+// waiter -> holder, through intersection
+typedef struct {
+    int waiter;
+    int holder;
+    int intersection;
+} WaitEdge;
+
+typedef struct {
+    int sim_sec;                     // simulated clock when the snapshot was taken
+    int intersection_count;
+    int stale;                       // intersections that could not be read consistently
+    int edge_count;
+    WaitEdge edges[WFG_MAX_EDGES];
+} WaitForGraph;
+
+// Builds the graph from intersections 0..count-1. Returns the number of edges
+int  wfg_snapshot(const SharedIntersection *shared, int count, WaitForGraph *g);
+
+// Looks for a cycle. If one is found and cycle is not NULL, the train IDs on it are
+// written to cycle[] (at most MAX_TRAINS) and their number to *cycle_len
+bool wfg_find_cycle(const WaitForGraph *g, int cycle[], int *cycle_len);
+
+// Writes the graph as a plain edge list, one "waiter holder intersection" per line
+void wfg_export(const WaitForGraph *g, FILE *out);
+
+#endif
@@ -8,7 +8,7 @@ Updated 4/13/2025
 
 /*Timestamping known working condition before merge to main. 4.20.2025 8:56PM CDT*/
 /*Timestamping known working condition with all branches merged before merge to main 4.20.2025 9:08 CDT*/
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
@@ -17,6 +17,9 @@ Updated 4/13/2025
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 #include "logger/logger.h"                         // Jason Greer
 #include "logger/csv_logger.h"                     // Jarett Woodard
@@ -26,35 +29,631 @@ Updated 4/13/2025
 #include "Shared_Memory_Setup/Memory_Segments.h"   // Steve Kuria
 #include "Basic_IPC_Workflow/resource_allocation_graph.h"  // Zachary Oyer
 #include "Basic_IPC_Workflow/fake_sec.h"           // Jake Pinell
+#include "logger/trace.h"
+#include "logger/flight_recorder.h"
+#include "logger/chrome_trace.h"
+#include "logger/rail_probes.h"
 
 // This file uses code from server.c authored by Jason Greer
 
 #define LINE_MAX 256
+#define SERVER_LOCK_WAIT_MS 100 // the server never blocks on a local lock longer than this
+#define PRINT_TRAINS_MAX 64     // trains listed at startup, big scenarios only get a count
 
-// helper to map intersection name in index in iEntries[]
-static int find_intersection_index(const IntersectionEntry entries[],
-                                   int count,
-                                   const char *name)
+// ACQ_SET requests that could not be granted when they arrived, oldest first.
+// Only the server touches this so it stays local instead of going in shared memory.
+typedef struct {
+    int train_id;
+    int count;
+    int idx[MAX_WINDOW];            // intersection indices, in global order
+    char first[MAX_NAME];           // first intersection of the train's window (echoed in GRANT)
+} PendingSet;
+
+static PendingSet pending_sets[MAX_TRAINS];
+static int pending_count = 0;
+
+// Waiters that asked for a timeout. idx is the intersection they wait on, -1 for a set.
+// A train only ever waits for one thing, so train_id identifies the entry
+typedef struct {
+    int train_id;
+    int idx;
+    char intersection[MAX_NAME];
+    struct timespec deadline;       // CLOCK_MONOTONIC
+} TimedWaiter;
+
+static TimedWaiter timed_waiters[MAX_TRAINS * 2];
+static int timed_count = 0;
+
+static void add_deadline(int train_id, int idx, const char *intersection, int timeout_ms)
+{
+    if (timeout_ms <= 0)
+        return;
+    if (timed_count == (int)(sizeof(timed_waiters) / sizeof(timed_waiters[0])))
+    {
+        LOG_SERVER_AT(LOG_LEVEL_WARN, "Timeout table full, Train %d waits without a deadline", train_id);
+        return;
+    }
+    TimedWaiter *tw = &timed_waiters[timed_count++];
+    tw->train_id = train_id;
+    tw->idx = idx;
+    strncpy(tw->intersection, intersection, MAX_NAME - 1);
+    tw->intersection[MAX_NAME - 1] = '\0';
+    clock_gettime(CLOCK_MONOTONIC, &tw->deadline);
+    tw->deadline.tv_sec += timeout_ms / 1000;
+    tw->deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (tw->deadline.tv_nsec >= 1000000000L)
+    {
+        tw->deadline.tv_sec++;
+        tw->deadline.tv_nsec -= 1000000000L;
+    }
+}
+
+// the train was granted, its deadline no longer applies
+static void clear_deadline(int train_id)
+{
+    for (int i = 0; i < timed_count; i++)
+    {
+        if (timed_waiters[i].train_id == train_id)
+        {
+            timed_waiters[i] = timed_waiters[--timed_count];
+            return;
+        }
+    }
+}
+
+// the global order is the order intersections appear in intersections.txt.
+// sorts the set into that order and drops duplicates, returns the new count
+static int order_set(int idx[], int count)
 {
+    for (int i = 1; i < count; i++)
+    {
+        int key = idx[i];
+        int j = i - 1;
+        while (j >= 0 && idx[j] > key)
+        {
+            idx[j + 1] = idx[j];
+            j--;
+        }
+        idx[j + 1] = key;
+    }
+
+    int unique = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (unique == 0 || idx[unique - 1] != idx[i])
+        {
+            idx[unique++] = idx[i];
+        }
+    }
+    return unique;
+}
+
+// grants every intersection in idx[] to the train or none of them.
+// idx[] must already be in global order so every set is taken low to high.
+// Returns 1 if granted, 0 if some intersection is full
+static int try_grant_set(Intersection locks[], const int idx[], int count, int train_id)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!has_capacity(shared_intersections, idx[i]))
+        {
+            return 0;
+        }
+    }
+
     for (int i = 0; i < count; i++)
     {
-        if (strcmp(entries[i].id, name) == 0)
+        add_holder(shared_intersections, idx[i], train_id);
+        if (acquire_lock_timed(&locks[idx[i]], SERVER_LOCK_WAIT_MS) != 0)
+        {
+            // undo what was already taken so the set stays all-or-nothing
+            remove_holder(shared_intersections, idx[i], train_id);
+            for (int j = i - 1; j >= 0; j--)
+            {
+                release_lock(&locks[idx[j]]);
+                remove_holder(shared_intersections, idx[j], train_id);
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Span bookkeeping for the latency histograms in the shm stats region, and for the
+// Chrome trace when it is on. A train waits for one thing at a time.
+// Train ids are unbounded (railfeed numbers them into the hundreds), so open spans live
+// in a hash table keyed by id: a train takes a slot when it starts waiting and frees
+// it once nothing of it is open. Every such train holds or waits somewhere, so at most
+// SPAN_LIVE trains have a slot at once; the table is twice that, so with ids handed out
+// in order a lookup is almost always the slot train_id % SPAN_SLOTS itself
+#define SPAN_LIVE  (NUM_INTERSECTIONS * MAX_TRAINS * 2 + MAX_TRAINS)
+#define SPAN_SLOTS (SPAN_LIVE * 2)
+
+typedef struct {
+    int used;
+    int train_id;
+    uint64_t wait_started;                      // 0 = not waiting
+    uint64_t hold_started[NUM_INTERSECTIONS];   // 0 = not holding
+} SpanSlot;
+
+static SpanSlot spans[SPAN_SLOTS];
+static int spans_live = 0;
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int tracked(int idx)
+{
+    return idx >= 0 && idx < NUM_INTERSECTIONS;
+}
+
+static int span_home(int train_id)
+{
+    return (unsigned)train_id % SPAN_SLOTS;
+}
+
+// the train's slot, a new one if create is set and it has none; NULL if there is none.
+// Linear probing from the home slot; the table is never more than half full
+static SpanSlot *span_slot(int train_id, int create)
+{
+    int i = span_home(train_id);
+    while (spans[i].used)
+    {
+        if (spans[i].train_id == train_id)
+            return &spans[i];
+        i = (i + 1) % SPAN_SLOTS;
+    }
+    if (!create || spans_live == SPAN_LIVE)
+        return NULL;
+    memset(&spans[i], 0, sizeof(spans[i]));
+    spans[i].used = 1;
+    spans[i].train_id = train_id;
+    spans_live++;
+    return &spans[i];
+}
+
+// empties slot i, moving later entries of its probe run back so every entry stays
+// reachable from its home slot without tombstones
+static void span_free(int i)
+{
+    for (int j = (i + 1) % SPAN_SLOTS; spans[j].used; j = (j + 1) % SPAN_SLOTS)
+    {
+        int home = span_home(spans[j].train_id);
+        // an entry whose home lies in (i, j] is already as close to it as it can be
+        if (i < j ? (home > i && home <= j) : (home > i || home <= j))
+            continue;
+        spans[i] = spans[j];
+        i = j;
+    }
+    spans[i].used = 0;
+    spans_live--;
+}
+
+// gives the slot back once the train has no wait or hold open
+// (it may move other slots, so the caller must be done with any SpanSlot pointer)
+static void span_done(SpanSlot *slot)
+{
+    if (slot->wait_started)
+        return;
+    for (int i = 0; i < NUM_INTERSECTIONS; i++)
+    {
+        if (slot->hold_started[i])
+            return;
+    }
+    span_free(slot - spans);
+}
+
+static void on_wait_begin(int train_id, int idx)
+{
+    ctrace_wait_begin(train_id, idx);
+    SpanSlot *slot = tracked(idx) ? span_slot(train_id, 1) : NULL;
+    if (slot)
+        slot->wait_started = mono_ns();
+}
+
+// a TIMEOUT or FAIL: the wait ends without a grant and is left out of the histogram
+static void on_wait_end(int train_id, const char *outcome)
+{
+    ctrace_wait_end(train_id, outcome);
+    SpanSlot *slot = span_slot(train_id, 0);
+    if (slot)
+    {
+        slot->wait_started = 0;
+        span_done(slot);
+    }
+}
+
+// a set's wait counts against every intersection in it
+static void on_grant(int train_id, const int idx[], int count)
+{
+    ctrace_grant(train_id, idx, count);
+    SpanSlot *slot = span_slot(train_id, 1);
+    if (!slot)
+        return;
+    uint64_t now = mono_ns();
+    RailStats *stats = shm_stats(shared_intersections);
+    for (int i = 0; i < count; i++)
+    {
+        if (!tracked(idx[i]))
+            continue;
+        if (slot->wait_started)
+            stats_record(stats, idx[i], STAT_WAIT, now - slot->wait_started);
+        slot->hold_started[idx[i]] = now;
+    }
+    slot->wait_started = 0;
+    span_done(slot);
+}
+
+static void on_release(int train_id, int idx)
+{
+    ctrace_release(train_id, idx);
+    SpanSlot *slot = span_slot(train_id, 0);
+    if (!slot || !tracked(idx) || !slot->hold_started[idx])
+        return;
+    stats_record(shm_stats(shared_intersections), idx, STAT_HOLD, mono_ns() - slot->hold_started[idx]);
+    slot->hold_started[idx] = 0;
+    span_done(slot);
+}
+
+// rate counters for railstat, by reply
+static void count_reply(const char *action)
+{
+    static const struct { const char *action; int counter; } map[] = {
+        { "GRANT", STAT_GRANTS }, { "WAIT", STAT_WAITS }, { "OK", STAT_RELEASES },
+        { "TIMEOUT", STAT_TIMEOUTS }, { "FAIL", STAT_FAILS },
+    };
+    for (size_t i = 0; i < sizeof(map) / sizeof(map[0]); i++)
+    {
+        if (strcmp(action, map[i].action) == 0)
+        {
+            stats_count(shm_stats(shared_intersections), map[i].counter);
+            return;
+        }
+    }
+}
+
+// SIGUSR1 asks for a flight recorder dump and SIGHUP for a capacity reload.
+// A handler that only set a flag could fire between the loop's check and its
+// blocking msgrcv and go unnoticed until the next message. So the server blocks both
+// signals in every thread, and one thread takes them with sigwait(): it sets the flag
+// and then queues a WAKE message, which msgrcv always returns.
+// SIGALRM comes from the timer set to the nearest waiter deadline and only wakes the
+// loop, which then expires what is due.
+static sigset_t server_signals;
+static int dump_requested = 0;
+static int reload_requested = 0;
+
+static void *signal_waiter(void *arg)
+{
+    int msgid = *(const int *)arg;
+    for (;;)
+    {
+        int sig;
+        if (sigwait(&server_signals, &sig) != 0)
+            continue;
+        if (sig == SIGHUP)
+            __atomic_store_n(&reload_requested, 1, __ATOMIC_RELEASE);
+        else if (sig == SIGUSR1)
+            __atomic_store_n(&dump_requested, 1, __ATOMIC_RELEASE);
+
+        Message wake;
+        memset(&wake, 0, sizeof(wake));
+        wake.mtype = 1;
+        strncpy(wake.action, "WAKE", sizeof(wake.action) - 1);
+        // with the queue full msgrcv has something to return anyway
+        msgsnd(msgid, &wake, sizeof(wake) - sizeof(long), IPC_NOWAIT);
+    }
+    return NULL;
+}
+
+static void write_flight_dump(void)
+{
+    FILE *out = fopen("flight_dump.txt", "w");
+    if (!out)
+    {
+        perror("[SERVER] fopen flight_dump.txt");
+        return;
+    }
+    flight_dump(out, flight_region, shared_intersections);
+    fclose(out);
+    LOG_SERVER("Flight recorder dumped to flight_dump.txt");
+}
+
+// sends an unsolicited reply (GRANT or TIMEOUT) to a train that was waiting.
+// op is what the train had asked for, for the trace
+static int send_reply(int msgid, int train_id, const char *intersection, const char *action, int op)
+{
+    Message reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.mtype = train_id + 100;
+    reply.train_id = train_id;
+    strncpy(reply.intersection, intersection, sizeof(reply.intersection) - 1);
+    strncpy(reply.action, action, sizeof(reply.action) - 1);
+
+    if (msgsnd(msgid, &reply, sizeof(reply) - sizeof(long), 0) == -1)
+    {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "msgsnd(%s) to Train %d failed: %s", action, train_id, strerror(errno));
+        return -1;
+    }
+    RAIL_PROBE3(reply_sent, train_id, action, intersection);
+    trace_event(train_id, intersection, op, trace_result_code(action));
+    count_reply(action);
+    return 0;
+}
+
+// arms the SIGALRM timer for the nearest deadline, or disarms it when nobody waits
+// with one, so msgrcv can block and still come back in time for the next TIMEOUT
+static void arm_deadline_timer(void)
+{
+    static int armed = 0;
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    if (timed_count == 0)
+    {
+        if (armed)
+            setitimer(ITIMER_REAL, &timer, NULL);
+        armed = 0;
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long nearest_ns = -1;
+    for (int i = 0; i < timed_count; i++)
+    {
+        long long left_ns = (timed_waiters[i].deadline.tv_sec - now.tv_sec) * 1000000000LL +
+                            (timed_waiters[i].deadline.tv_nsec - now.tv_nsec);
+        if (nearest_ns < 0 || left_ns < nearest_ns)
+            nearest_ns = left_ns;
+    }
+    if (nearest_ns < 1000)
+        nearest_ns = 1000; // a zero it_value would disarm it
+    timer.it_value.tv_sec = nearest_ns / 1000000000LL;
+    timer.it_value.tv_usec = (nearest_ns % 1000000000LL + 999) / 1000;
+    if (timer.it_value.tv_usec >= 1000000)
+    {
+        timer.it_value.tv_sec++;
+        timer.it_value.tv_usec -= 1000000;
+    }
+    setitimer(ITIMER_REAL, &timer, NULL);
+    armed = 1;
+}
+
+// takes waiters whose deadline passed out of their queue and tells them TIMEOUT
+static void expire_waiters(int msgid)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int i = 0;
+    while (i < timed_count)
+    {
+        TimedWaiter *tw = &timed_waiters[i];
+        if (tw->deadline.tv_sec > now.tv_sec ||
+            (tw->deadline.tv_sec == now.tv_sec && tw->deadline.tv_nsec > now.tv_nsec))
+        {
+            i++;
+            continue;
+        }
+
+        int removed = 0;
+        if (tw->idx >= 0)
+        {
+            removed = remove_waiter(shared_intersections, tw->idx, tw->train_id);
+        }
+        else
+        {
+            for (int p = 0; p < pending_count; p++)
+            {
+                if (pending_sets[p].train_id == tw->train_id)
+                {
+                    for (int j = p; j < pending_count - 1; j++)
+                    {
+                        pending_sets[j] = pending_sets[j + 1];
+                    }
+                    pending_count--;
+                    removed = 1;
+                    break;
+                }
+            }
+        }
+
+        if (removed && send_reply(msgid, tw->train_id, tw->intersection, "TIMEOUT",
+                                  tw->idx < 0 ? TRACE_OP_ACQ_SET : TRACE_OP_ACQUIRE) == 0)
+        {
+            on_wait_end(tw->train_id, "TIMEOUT");
+            LOG_SERVER("TIMEOUT: Train %d gave up waiting for %s", tw->train_id, tw->intersection);
+        }
+        *tw = timed_waiters[--timed_count]; // same slot now holds an unchecked entry
+    }
+}
+
+// grants idx to its queued single waiters while it has room: one after a release,
+// as many as fit after a reload raised the capacity
+static void admit_waiters(int msgid, Intersection locks[], int idx, const char *intersection)
+{
+    while (has_capacity(shared_intersections, idx))
+    {
+        int next_train = dequeue_waiter(shared_intersections, idx);
+        if (next_train == -1)
+            return;
+        RAIL_PROBE2(waiter_dequeued, next_train, idx);
+        if (!add_holder(shared_intersections, idx, next_train) ||
+            acquire_lock_timed(&locks[idx], SERVER_LOCK_WAIT_MS) != 0)
+        {
+            // If lock acquisition fails, put train back in queue
+            remove_holder(shared_intersections, idx, next_train);
+            enqueue_waiter(shared_intersections, idx, next_train);
+            return;
+        }
+        // Send GRANT to waiting train
+        clear_deadline(next_train);
+        on_grant(next_train, &idx, 1);
+        if (send_reply(msgid, next_train, intersection, "GRANT", TRACE_OP_ACQUIRE) == 0)
+        {
+            setFakeSec(1);  // Increment time when granting to waiting train
+            LOG_SERVER("Granted %s to waiting Train %d", intersection, next_train);
+        }
+    }
+}
+
+// after a release, hand out any queued sets that now fit (oldest first)
+static void serve_pending_sets(int msgid, Intersection locks[])
+{
+    int i = 0;
+    while (i < pending_count)
+    {
+        PendingSet *ps = &pending_sets[i];
+        if (try_grant_set(locks, ps->idx, ps->count, ps->train_id))
+        {
+            RAIL_PROBE2(waiter_dequeued, ps->train_id, -1);
+            clear_deadline(ps->train_id);
+            on_grant(ps->train_id, ps->idx, ps->count);
+            if (send_reply(msgid, ps->train_id, ps->first, "GRANT", TRACE_OP_ACQ_SET) == 0)
+            {
+                setFakeSec(1);
+                LOG_SERVER("Granted set of %d intersections to waiting Train %d",
+                           ps->count, ps->train_id);
+            }
+            // drop it from the queue, keeping arrival order
+            for (int j = i; j < pending_count - 1; j++)
+            {
+                pending_sets[j] = pending_sets[j + 1];
+            }
+            pending_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+// shared memory tracks at most MAX_TRAINS holders, so that is the most any
+// intersection admits; the local lock gets the same value so both agree
+static int server_capacity(int capacity)
+{
+    return capacity > MAX_TRAINS ? MAX_TRAINS : capacity;
+}
+
+// Re-reads the intersections from where the scenario came from and applies any new
+// capacity to the running server. Names and their order are fixed for its lifetime
+// (they are the shared memory indices), so an intersection that is new or missing in
+// the file is reported and left alone. A raised capacity admits waiters at once; a
+// lowered one keeps its holders and grants nothing until they are under it
+static void reload_capacities(int msgid, Intersection locks[], const Scenario *scenario,
+                              const char *image_path, const char *trains_path, const char *intersections_path)
+{
+    Scenario fresh;
+    if (scenario_open_intersections(&fresh, image_path, trains_path, intersections_path) == -1)
+    {
+        LOG_SERVER_AT(LOG_LEVEL_WARN, "Reload failed, capacities unchanged");
+        return;
+    }
+
+    int seen[NUM_INTERSECTIONS] = { 0 };
+    int changed = 0;
+    for (int i = 0; i < fresh.intersection_count; i++)
+    {
+        const char *name = scenario_name(&fresh, i);
+        int idx = find_intersection_index(scenario, name);
+        if (idx < 0)
+        {
+            LOG_SERVER_AT(LOG_LEVEL_WARN, "Reload: %s is not in the running scenario, ignored", name);
+            continue;
+        }
+        seen[idx] = 1;
+        int capacity = server_capacity(fresh.intersections[i].capacity);
+        int old = locks[idx].capacity;
+        if (capacity == old)
+            continue;
+
+        IntersectionSnapshot snap;
+        if (!snapshot_intersection(shared_intersections, idx, &snap) ||
+            resize_lock(&locks[idx], capacity, snap.held_count) == -1)
         {
-            return i;
+            LOG_SERVER_AT(LOG_LEVEL_ERROR, "Reload: could not resize %s to %d", name, capacity);
+            continue;
         }
+        set_capacity(shared_intersections, idx, capacity);
+        changed++;
+        LOG_SERVER("Reload: %s capacity %d -> %d, %d holding, %d waiting",
+                   name, old, capacity, snap.held_count, snap.wait_count);
+        admit_waiters(msgid, locks, idx, name);
     }
-    return -1;
+    for (int idx = 0; idx < scenario->intersection_count; idx++)
+    {
+        if (!seen[idx])
+            LOG_SERVER_AT(LOG_LEVEL_WARN, "Reload: %s is missing, capacity stays %d",
+                          scenario_name(scenario, idx), locks[idx].capacity);
+    }
+    serve_pending_sets(msgid, locks);
+    scenario_free(&fresh);
+    LOG_SERVER("Capacities reloaded, %d changed", changed);
 }
 
-int main(){
+int main(int argc, char *argv[]){
+    // -T trains.txt, -I intersections.txt: scenario files other than text_files/
+    // -S image: a railc image, like RAIL_SCENARIO
+    const char *trains_path = NULL, *intersections_path = NULL, *image_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "T:I:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'T': trains_path = optarg; break;
+        case 'I': intersections_path = optarg; break;
+        case 'S': image_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-T trains.txt] [-I intersections.txt] [-S scenario.img]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    // blocked before any thread starts, so only signal_waiter ever takes them
+    sigemptyset(&server_signals);
+    sigaddset(&server_signals, SIGUSR1);
+    sigaddset(&server_signals, SIGHUP);
+    sigaddset(&server_signals, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &server_signals, NULL);
+
     // initialize both loggers
     log_init("simulation.log", 1);
     LOG_SERVER("Initializing Train Movement Simulation");
 
+    // last events of every process, kept in shared memory for SIGUSR1 and raildump
+    flight_create();
+
+    // wait and occupancy spans for chrome://tracing or Perfetto
+    const char *chrome_path = getenv("RAIL_CHROME_TRACE");
+    if (chrome_path && ctrace_open(chrome_path) == 0)
+    {
+        LOG_SERVER("Chrome trace to %s", chrome_path);
+    }
+
+    // contention of the intersection and clock mutexes, also switchable with raillocks on|off
+    const char *lock_profile = getenv("RAIL_LOCK_PROFILE");
+    if (lock_profile && strcmp(lock_profile, "0") != 0)
+    {
+        __atomic_store_n(&shm_stats(shared_intersections)->lock_profiling, 1, __ATOMIC_RELAXED);
+        LOG_SERVER("Lock profiling on");
+    }
+
+    // binary trace of every reply, decoded offline with raildecode
+    const char *trace_dir = getenv("RAIL_TRACE");
+    if (trace_dir && trace_open(trace_dir, "server") == 0)
+    {
+        LOG_SERVER("Tracing to %s", trace_dir);
+    }
+
     FILE *csv_file = csv_logger_init();
     if (!csv_file)
     {
-        LOG_SERVER("Failed to initialize CSV logger");
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Failed to initialize CSV logger");
         fprintf(stderr, "[SERVER] Failed to initialize CSV logger.\n");
         exit(1);
     }
@@ -85,26 +684,50 @@ int main(){
     // }
     // LOG_SERVER("Shared memory initialized");
 
-    // parse trains
-    TrainEntry trains[LINE_MAX];
-    int trainCount = getTrains(trains);
+    // the compiled image from -S or RAIL_SCENARIO, or intersections.txt then trains.txt,
+    // so the intersection ids are the shared memory indices
+    Scenario scenario;
+    if (scenario_open(&scenario, image_path, trains_path, intersections_path) == -1)
+    {
+        const char *from = image_path ? image_path : trains_path ? trains_path : intersections_path;
+        if (!from) from = getenv("RAIL_SCENARIO");
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Could not load the scenario from %s", from ? from : "text_files");
+        fprintf(stderr, "[SERVER] Could not load the scenario from %s.\n", from ? from : "text_files");
+        exit(1);
+    }
+    int intersectionCount = scenario.intersection_count;
+    int trainCount = scenario.train_count;
+    LOG_SERVER("Parsed %d intersections", intersectionCount);
+    printIntersectionEntries(&scenario);
     LOG_SERVER("Parsed %d trains", trainCount);
-    printTrainEntries(trains, trainCount);
+    printTrainEntries(&scenario, PRINT_TRAINS_MAX);
 
-    // parse intersections
-    IntersectionEntry iEntries[LINE_MAX];
-    int intersectionCount = getIntersections(iEntries);
-    LOG_SERVER("Parsed %d intersections", intersectionCount);
-    printIntersectionEntries(iEntries, intersectionCount);
+    if (intersectionCount > NUM_INTERSECTIONS)
+    {
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Too many intersections (%d), shared memory holds %d",
+                   intersectionCount, NUM_INTERSECTIONS);
+        fprintf(stderr, "[SERVER] Too many intersections (%d > %d).\n",
+                intersectionCount, NUM_INTERSECTIONS);
+        exit(1);
+    }
 
     // build and initialize local locks array
     Intersection locks[LINE_MAX];
     for (int i = 0; i < intersectionCount; i++)
     {
+        // admission is checked against shared memory, so it needs the parsed capacity
+        const char *name = scenario_name(&scenario, i);
+        int capacity = server_capacity(scenario.intersections[i].capacity);
+        set_capacity(shared_intersections, i, capacity);
+        trace_intern(name); // interned in order, so trace id == index
+        flight_set_name(i, name);
+        ctrace_name_intersection(i, name);
+        stats_set_name(shm_stats(shared_intersections), i, name);
+
         // copy name & capacity
-        strncpy(locks[i].name, iEntries[i].id, MAX_NAME_LENGTH - 1);
+        strncpy(locks[i].name, name, MAX_NAME_LENGTH - 1);
         locks[i].name[MAX_NAME_LENGTH - 1] = '\0';
-        locks[i].capacity = iEntries[i].capacity;
+        locks[i].capacity = capacity;
 
         // initialize the lock
         if (locks[i].capacity == 1)
@@ -124,30 +747,65 @@ int main(){
     int msgid = msgget(MSG_KEY, IPC_CREAT | 0666);
     if (msgid < 0)
     {
-        LOG_SERVER(" msgget failed: %s", strerror(errno));
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, " msgget failed: %s", strerror(errno));
         perror("[SERVER] msgget");
         exit(1);
     }
     LOG_SERVER("Message queue ready (ID: %d)", msgid);
-    printf("%s [SERVER] Message queue ready (ID: %d)\n", getFakeTime(), msgid);
+    LOG_CONSOLE(LOG_LEVEL_INFO, "[SERVER] Message queue ready (ID: %d)\n", msgid);
+
+    // SIGUSR1 dumps the flight recorder, SIGHUP reloads the capacities (see signal_waiter)
+    pthread_t signal_thread;
+    if (pthread_create(&signal_thread, NULL, signal_waiter, &msgid) == 0)
+    {
+        pthread_detach(signal_thread);
+    }
+    else
+    {
+        LOG_SERVER_AT(LOG_LEVEL_WARN, "No signal thread, SIGUSR1 and SIGHUP are ignored");
+    }
 
     // main server loop
     Message req, resp;
     while (1)
     {
+        if (__atomic_exchange_n(&dump_requested, 0, __ATOMIC_ACQ_REL) && flight_region)
+        {
+            write_flight_dump();
+        }
+        if (__atomic_exchange_n(&reload_requested, 0, __ATOMIC_ACQ_REL))
+        {
+            reload_capacities(msgid, locks, &scenario, image_path, trains_path, intersections_path);
+        }
+        // while someone waits with a deadline, the timer wakes msgrcv at the nearest one
+        // so expired waiters get their TIMEOUT even if no other message arrives
+        if (timed_count > 0)
+        {
+            expire_waiters(msgid);
+        }
+        arm_deadline_timer();
         if (msgrcv(msgid, &req, sizeof(req) - sizeof(long), 1, 0) == -1)
         {
-            LOG_SERVER("msgrcv failed: %s", strerror(errno));
+            if (errno == EINTR)
+                continue;
+            LOG_SERVER_AT(LOG_LEVEL_ERROR, "msgrcv failed: %s", strerror(errno));
             perror("[SERVER] msgrcv");
             continue;
         }
 
+        // only there to get out of msgrcv, the flags are checked at the top
+        if (strcmp(req.action, "WAKE") == 0)
+            continue;
+
         // if STOP then break
         if (strcmp(req.action, "STOP") == 0)
         {
             LOG_SERVER("Received STOP signal. Exiting server loop");
             break;
         }
+        uint64_t received_ns = mono_ns();
+        RAIL_PROBE3(request_received, req.train_id, req.action, req.intersection);
+        stats_count(shm_stats(shared_intersections), STAT_REQUESTS);
 
         // prepare common parts of response
         memset(&resp, 0, sizeof(resp));
@@ -158,47 +816,122 @@ int main(){
         //increments time in shared memory through logger.h
         setFakeSec(1);
         //Logs request. gettime is called inside the macro
-        LOG_SERVER("Received: Train %d requests \"%s\" on %s",req.train_id, req.action, req.intersection);
+        LOG_SERVER_AT(LOG_LEVEL_DEBUG, "Received: Train %d requests \"%s\" on %s",req.train_id, req.action, req.intersection);
 
         //find which lock to use
-        int idx = find_intersection_index(iEntries, intersectionCount, req.intersection);
+        int idx = find_intersection_index(&scenario, req.intersection);
+        RAIL_PROBE2(lookup_done, req.train_id, idx);
         if (idx < 0)
         {
             strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
-            LOG_SERVER("Unknown intersection %s", req.intersection);
+            LOG_SERVER_AT(LOG_LEVEL_WARN, "Unknown intersection %s", req.intersection);
         }
         else
         {
+            if (strcmp(req.action, "RELEASE") != 0)
+            {
+                on_wait_begin(req.train_id, idx);
+            }
+
+            // ACQ_SET: the whole lookahead window is granted at once, taken in global order
+            if (strcmp(req.action, "ACQ_SET") == 0)
+            {
+                int set_idx[MAX_WINDOW];
+                int count = (req.set_count > 0 && req.set_count <= MAX_WINDOW) ? req.set_count : 0;
+                int valid = count > 0;
+                for (int i = 0; i < count; i++)
+                {
+                    set_idx[i] = find_intersection_index(&scenario, req.set[i]);
+                    if (set_idx[i] < 0)
+                    {
+                        LOG_SERVER_AT(LOG_LEVEL_WARN, "Unknown intersection %s in set from Train %d",
+                                   req.set[i], req.train_id);
+                        valid = 0;
+                    }
+                }
+
+                if (!valid)
+                {
+                    strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
+                }
+                else
+                {
+                    count = order_set(set_idx, count);
+                    if (try_grant_set(locks, set_idx, count, req.train_id))
+                    {
+                        strncpy(resp.action, "GRANT", sizeof(resp.action) - 1);
+                        on_grant(req.train_id, set_idx, count);
+                        LOG_SERVER("GRANTED set of %d intersections starting at %s to Train %d",
+                                   count, req.intersection, req.train_id);
+                    }
+                    else if (pending_count < MAX_TRAINS)
+                    {
+                        PendingSet *ps = &pending_sets[pending_count++];
+                        ps->train_id = req.train_id;
+                        ps->count = count;
+                        memcpy(ps->idx, set_idx, sizeof(int) * count);
+                        strncpy(ps->first, req.intersection, MAX_NAME - 1);
+                        ps->first[MAX_NAME - 1] = '\0';
+                        strncpy(resp.action, "WAIT", sizeof(resp.action) - 1);
+                        add_deadline(req.train_id, -1, req.intersection, req.timeout_ms);
+                        LOG_SERVER("WAITING: set busy, Train %d queued for set starting at %s",
+                                   req.train_id, req.intersection);
+                    }
+                    else
+                    {
+                        strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
+                        LOG_SERVER_AT(LOG_LEVEL_WARN, "Set queue full, rejected Train %d", req.train_id);
+                    }
+                }
+            }
+
             // process ACQUIRE or RELEASE on locks[idx] and update shared memory tracking
-            if (strcmp(req.action, "ACQUIRE") == 0)
+            else if (strcmp(req.action, "ACQUIRE") == 0)
             {
                 //attempt to add the train as a holder in shared memory. If successful, try to acquire the local lock. Otherwise, put train in exit queue.
                 if (add_holder(shared_intersections, idx, req.train_id))
                 {
-                    int result = acquire_lock(&locks[idx]);
+                    int result = acquire_lock_timed(&locks[idx], SERVER_LOCK_WAIT_MS);
 
                     if (result == 0)
                     {
                         strncpy(resp.action, "GRANT", sizeof(resp.action) - 1);
+                        on_grant(req.train_id, &idx, 1);
                         LOG_SERVER("GRANTED %s to Train %d", req.intersection, req.train_id);
                     }
                     else
                     {
                         // if local lock acquisition fails remove the holder and queue the train
                         remove_holder(shared_intersections, idx, req.train_id);
-                        enqueue_waiter(shared_intersections, idx, req.train_id);
-                        strncpy(resp.action, "WAIT", sizeof(resp.action) - 1);
-                        LOG_SERVER("WAITING: Local lock error, Train %d queued for %s", 
-                                 req.train_id, req.intersection);
+                        if (enqueue_waiter(shared_intersections, idx, req.train_id))
+                        {
+                            add_deadline(req.train_id, idx, req.intersection, req.timeout_ms);
+                            strncpy(resp.action, "WAIT", sizeof(resp.action) - 1);
+                            LOG_SERVER_AT(LOG_LEVEL_WARN, "WAITING: Local lock error, Train %d queued for %s", 
+                                     req.train_id, req.intersection);
+                        }
+                        else
+                        {
+                            strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
+                            LOG_SERVER_AT(LOG_LEVEL_WARN, "Wait queue of %s full, rejected Train %d",
+                                       req.intersection, req.train_id);
+                        }
                     }
                 }
-                else
+                else if (enqueue_waiter(shared_intersections, idx, req.train_id))
                 {
                     // intersection at capacity add the train to the waiting queue
-                    enqueue_waiter(shared_intersections, idx, req.train_id);
+                    add_deadline(req.train_id, idx, req.intersection, req.timeout_ms);
                     strncpy(resp.action, "WAIT", sizeof(resp.action) - 1);
                     LOG_SERVER("WAITING: full, Train %d queued for %s",req.train_id, req.intersection);
                 }
+                else
+                {
+                    // never queued, so no GRANT or TIMEOUT would follow a WAIT
+                    strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
+                    LOG_SERVER_AT(LOG_LEVEL_WARN, "Wait queue of %s full, rejected Train %d",
+                               req.intersection, req.train_id);
+                }
             }
 
             else // RELEASE
@@ -210,61 +943,26 @@ int main(){
                     {
 
                         strncpy(resp.action, "OK", sizeof(resp.action) - 1);
+                        on_release(req.train_id, idx);
                         LOG_SERVER("Released %s from Train %d", req.intersection, req.train_id);
 
                         //check of any trains are waiting
-                        int next_train = dequeue_waiter(shared_intersections, idx);
-                        if (next_train != -1)
-                        {
-                            if (add_holder(shared_intersections, idx, next_train))
-                            {
-                                result = acquire_lock(&locks[idx]);
-                                if (result == 0)
-                                {
-                                    // Send GRANT to waiting train
-                                    Message grant_msg;
-                                    memset(&grant_msg, 0, sizeof(grant_msg));
-                                    grant_msg.mtype = next_train + 100;
-                                    grant_msg.train_id = next_train;
-                                    strncpy(grant_msg.intersection,
-                                            req.intersection,
-                                            sizeof(grant_msg.intersection) - 1);
-                                    strncpy(grant_msg.action, "GRANT", 
-                                           sizeof(grant_msg.action) - 1);
-
-                                    if (msgsnd(msgid, &grant_msg, 
-                                             sizeof(grant_msg) - sizeof(long), 0) == -1)
-                                    {
-                                        LOG_SERVER("msgsnd(GRANT) to Train %d failed: %s",
-                                                   next_train, strerror(errno));
-                                    }
-                                    else
-                                    {
-                                        setFakeSec(1);  // Increment time when granting to waiting train
-                                        LOG_SERVER("Granted %s to waiting Train %d", 
-                                                  req.intersection, next_train);
-                                    }
-                                }
-                                else
-                                {
-                                    // If lock acquisition fails, put train back in queue
-                                    remove_holder(shared_intersections, idx, next_train);
-                                    enqueue_waiter(shared_intersections, idx, next_train);
-                                }
-                            }
-                        }
+                        admit_waiters(msgid, locks, idx, req.intersection);
+
+                        // single waiters go first, then any queued set that now fits
+                        serve_pending_sets(msgid, locks);
                     }
                     else
                     {
                         strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
-                        LOG_SERVER("Failed to remove Train %d from holders of %s", 
+                        LOG_SERVER_AT(LOG_LEVEL_ERROR, "Failed to remove Train %d from holders of %s", 
                                  req.train_id, req.intersection);
                     }
                 }
                 else
                 {
                     strncpy(resp.action, "FAIL", sizeof(resp.action) - 1);
-                    LOG_SERVER("Failed to release %s from Train %d", 
+                    LOG_SERVER_AT(LOG_LEVEL_ERROR, "Failed to release %s from Train %d", 
                              req.intersection, req.train_id);
                 }
             }
@@ -275,27 +973,44 @@ int main(){
             setFakeSec(1);
         }
         
+        if (strcmp(resp.action, "FAIL") == 0)
+        {
+            on_wait_end(req.train_id, "FAIL");
+        }
+        if (strcmp(req.action, "RELEASE") != 0)
+        {
+            RAIL_PROBE3(admission, req.train_id, idx, resp.action);
+        }
+
         if (msgsnd(msgid, &resp, sizeof(resp) - sizeof(long), 0) == -1)
         {
-            LOG_SERVER("msgsnd failed: %s", strerror(errno));
+            LOG_SERVER_AT(LOG_LEVEL_ERROR, "msgsnd failed: %s", strerror(errno));
             perror("[SERVER] msgsnd");
         }
         else
         {
-            LOG_SERVER("Sent response: Train %d \"%s\" on %s",
+            RAIL_PROBE3(reply_sent, resp.train_id, resp.action, resp.intersection);
+            trace_event(resp.train_id, resp.intersection,
+                        trace_op_code(req.action), trace_result_code(resp.action));
+            count_reply(resp.action);
+            LOG_SERVER_AT(LOG_LEVEL_DEBUG, "Sent response: Train %d \"%s\" on %s",
                        resp.train_id, resp.action, resp.intersection);
-            printf("%s [SERVER] Sent response: Train %d \"%s\" on %s\n", getFakeTime(),
-                   resp.train_id, resp.action, resp.intersection);
+            LOG_CONSOLE(LOG_LEVEL_DEBUG, "[SERVER] Sent response: Train %d \"%s\" on %s\n",
+                        resp.train_id, resp.action, resp.intersection);
+        }
+        if (idx >= 0)
+        {
+            stats_record(shm_stats(shared_intersections), idx, STAT_SERVICE, mono_ns() - received_ns);
         }
     }
 
     // clean the queue only after receiving STOP signal
     if (msgctl(msgid, IPC_RMID, NULL) == -1) {
-        LOG_SERVER("msgctl(IPC_RMID) failed: %s", strerror(errno));
+        LOG_SERVER_AT(LOG_LEVEL_ERROR, "msgctl(IPC_RMID) failed: %s", strerror(errno));
         perror("[SERVER] msgctl");
     } else {
         LOG_SERVER("Message queue removed");
-        printf("%s [SERVER] Message queue removed. Exiting.\n", getFakeTime());
+        LOG_CONSOLE(LOG_LEVEL_INFO, "[SERVER] Message queue removed. Exiting.\n");
     }
 
     // Give train simulator time to clean up its resources
@@ -303,6 +1018,17 @@ int main(){
 
     // final cleanup
     LOG_SERVER("SIMULATION COMPLETE. All trains reached destinations.");
+    printf("\nLatency per intersection (wait = ACQUIRE to GRANT, hold = GRANT to RELEASE):\n");
+    stats_print(stdout, shm_stats(shared_intersections));
+    if (__atomic_load_n(&shm_stats(shared_intersections)->lock_profiling, __ATOMIC_RELAXED))
+    {
+        printf("\nMutex contention, most time blocked first:\n");
+        stats_print_locks(stdout, shm_stats(shared_intersections));
+    }
+    scenario_free(&scenario);
+    trace_close();
+    ctrace_close();
+    flight_destroy();
     log_close();
     exit(0); // terminate
 }
\ No newline at end of file
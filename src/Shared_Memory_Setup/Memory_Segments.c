@@ -19,12 +19,23 @@
 
 SharedIntersection* shared_intersections = NULL;
 
+// Seqlock around the tracking fields. Writers already hold si->mutex, the counter only
+// lets lock-free readers (snapshot_intersection) notice that they raced a writer.
+static inline void seq_write_begin(SharedIntersection *si) {
+    __atomic_store_n(&si->seq, si->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seq_write_end(SharedIntersection *si) {
+    __atomic_store_n(&si->seq, si->seq + 1, __ATOMIC_RELEASE);
+}
+
 // Function to initialize shared memory and intersections
 SharedIntersection* init_shared_memory(const char *shm_name, size_t *shm_size) {
     int shm_fd;
 
     // Calculate total size for all intersections
-    *shm_size = sizeof(SharedIntersection) * NUM_INTERSECTIONS;
+    *shm_size = SHM_SEGMENT_SIZE;
 
     // Tries to open an existing shared memory object
     shm_fd = shm_open(shm_name, O_RDWR, 0666);
@@ -44,6 +55,20 @@ SharedIntersection* init_shared_memory(const char *shm_name, size_t *shm_size) {
     }
 }
 
+    // An object left by an older build can be shorter than the segment is now (the
+    // stats region came later); grow it so nothing past its old end faults
+    struct stat st;
+    if (fstat(shm_fd, &st) == -1) {
+        perror("fstat");
+        close(shm_fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < *shm_size && ftruncate(shm_fd, *shm_size) == -1) {
+        perror("ftruncate");
+        close(shm_fd);
+        return NULL;
+    }
+
     // Map the shared memory object into address space
     shared_intersections = mmap(NULL, *shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
     if (shared_intersections == MAP_FAILED) {
@@ -110,6 +135,7 @@ SharedIntersection* init_shared_memory(const char *shm_name, size_t *shm_size) {
         }
 
         // Initialize tracking counts and queues
+        si->seq = 0;
         si->held_count = 0;
         si->wait_count = 0;
         memset(si->holders, 0, sizeof(si->holders));
@@ -122,6 +148,32 @@ SharedIntersection* init_shared_memory(const char *shm_name, size_t *shm_size) {
     return shared_intersections;
 }
 
+// Maps an existing segment read-only. Used by monitors that must never take the mutexes
+SharedIntersection* attach_shared_memory(const char *shm_name, size_t *shm_size) {
+    *shm_size = SHM_SEGMENT_SIZE;
+
+    int shm_fd = shm_open(shm_name, O_RDONLY, 0);
+    if (shm_fd == -1) {
+        perror("shm_open");
+        return NULL;
+    }
+    // a monitor cannot grow it, so a segment from an older server is refused
+    struct stat st;
+    if (fstat(shm_fd, &st) == -1 || (size_t)st.st_size < *shm_size) {
+        fprintf(stderr, "%s: segment is from an older build, restart the server\n", shm_name);
+        close(shm_fd);
+        return NULL;
+    }
+
+    SharedIntersection *shared = mmap(NULL, *shm_size, PROT_READ, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    return shared;
+}
+
 // Function to clean up shared memory
 void destroy_shared_memory(SharedIntersection *shared_intersections, const char *shm_name, size_t shm_size) {
     for (int i = 0; i < NUM_INTERSECTIONS; i++) {
@@ -154,13 +206,15 @@ void destroy_shared_memory(SharedIntersection *shared_intersections, const char
 // Attempts to add train_id as a holder of intersection idx. Returns 1 if added, 0 if at capacity
 int add_holder(SharedIntersection *shared, int idx, int train_id) {
     SharedIntersection *si = &shared[idx];
-    pthread_mutex_lock(&si->mutex);
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
     if (si->held_count < si->capacity) {
+        seq_write_begin(si);
         si->holders[si->held_count++] = train_id;
-        pthread_mutex_unlock(&si->mutex);
+        seq_write_end(si);
+        shm_unlock(shared, idx, LOCK_SITE_TRACKING);
         return 1;
     }
-    pthread_mutex_unlock(&si->mutex);
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
     return 0;
 }
 
@@ -169,33 +223,38 @@ int add_holder(SharedIntersection *shared, int idx, int train_id) {
 int remove_holder(SharedIntersection *shared, int idx, int train_id) {
     SharedIntersection *si = &shared[idx];
     int found = 0;
-    pthread_mutex_lock(&si->mutex);
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
     for (int i = 0; i < si->held_count; i++) {
         if (si->holders[i] == train_id) {
+            seq_write_begin(si);
             // shift left
             for (int j = i; j < si->held_count - 1; j++) {
                 si->holders[j] = si->holders[j+1];
             }
             si->held_count--;
+            seq_write_end(si);
             found = 1;
             break;
         }
     }
-    pthread_mutex_unlock(&si->mutex);
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
     return found;
 }
 
-//Enqueues a waiting train. Caller mist handle capacity of wait_queue
+// Enqueues a waiting train. Returns 1 if queued, 0 if the wait_queue is full
 
-void enqueue_waiter(SharedIntersection *shared, int idx, int train_id) {
+int enqueue_waiter(SharedIntersection *shared, int idx, int train_id) {
     SharedIntersection *si = &shared[idx];
-    pthread_mutex_lock(&si->mutex);
+    int queued = 0;
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
     if (si->wait_count < MAX_TRAINS) {
+        seq_write_begin(si);
         si->wait_queue[si->wait_count++] = train_id;
-    } else {
-        fprintf(stderr, "Warning: wait_queue full on intersection %d\n", idx);
+        seq_write_end(si);
+        queued = 1;
     }
-    pthread_mutex_unlock(&si->mutex);
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
+    return queued;
 }
 
 // Dequeues the oldest waiting tain, returns -1 if none
@@ -203,15 +262,88 @@ void enqueue_waiter(SharedIntersection *shared, int idx, int train_id) {
 int dequeue_waiter(SharedIntersection *shared, int idx) {
     SharedIntersection *si = &shared[idx];
     int next = -1;
-    pthread_mutex_lock(&si->mutex);
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
     if (si->wait_count > 0) {
+        seq_write_begin(si);
         next = si->wait_queue[0];
         // shift left
         for (int i = 0; i < si->wait_count - 1; i++) {
             si->wait_queue[i] = si->wait_queue[i+1];
         }
         si->wait_count--;
+        seq_write_end(si);
     }
-    pthread_mutex_unlock(&si->mutex);
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
     return next;
-}
\ No newline at end of file
+}
+
+// Removes train_id from the wait queue wherever it is (timed-out waiters). Returns 1 if found
+
+int remove_waiter(SharedIntersection *shared, int idx, int train_id) {
+    SharedIntersection *si = &shared[idx];
+    int found = 0;
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
+    for (int i = 0; i < si->wait_count; i++) {
+        if (si->wait_queue[i] == train_id) {
+            seq_write_begin(si);
+            // shift left, keeps FIFO order of the others
+            for (int j = i; j < si->wait_count - 1; j++) {
+                si->wait_queue[j] = si->wait_queue[j+1];
+            }
+            si->wait_count--;
+            seq_write_end(si);
+            found = 1;
+            break;
+        }
+    }
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
+    return found;
+}
+
+// Returns 1 if intersection idx can take another holder, 0 if at capacity
+
+int has_capacity(SharedIntersection *shared, int idx) {
+    SharedIntersection *si = &shared[idx];
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
+    int free_slot = si->held_count < si->capacity;
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
+    return free_slot;
+}
+
+// Overwrites the capacity of intersection idx (server copies the parsed values in at startup)
+
+void set_capacity(SharedIntersection *shared, int idx, int capacity) {
+    SharedIntersection *si = &shared[idx];
+    if (capacity > MAX_TRAINS) capacity = MAX_TRAINS; // holders[] is only MAX_TRAINS wide
+    shm_lock(shared, idx, LOCK_SITE_TRACKING);
+    seq_write_begin(si);
+    si->capacity = capacity;
+    seq_write_end(si);
+    shm_unlock(shared, idx, LOCK_SITE_TRACKING);
+}
+
+// Seqlock read: copy the fields, then retry if the version was odd or moved while copying.
+// Never blocks the server, so it is safe to call from a monitor at any rate.
+
+int snapshot_intersection(const SharedIntersection *shared, int idx, IntersectionSnapshot *out) {
+    const SharedIntersection *si = &shared[idx];
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        unsigned int before = __atomic_load_n(&si->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) continue; // writer in progress
+
+        out->capacity = si->capacity;
+        out->held_count = si->held_count;
+        out->wait_count = si->wait_count;
+        memcpy(out->holders, si->holders, sizeof(out->holders));
+        memcpy(out->wait_queue, si->wait_queue, sizeof(out->wait_queue));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&si->seq, __ATOMIC_RELAXED) == before) {
+            // counts come from the same version as the arrays, clamp only against torn garbage
+            if (out->held_count < 0 || out->held_count > MAX_TRAINS) out->held_count = 0;
+            if (out->wait_count < 0 || out->wait_count > MAX_TRAINS) out->wait_count = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -5,12 +5,17 @@
 // 4-4-2025
 // This header file defines a shared memory structure for intersections—comprising a mutex, a semaphore pointer, capacity, and semaphore name—and declares functions to initialize and clean up this shared memory resource.
 // 4-11-25: Created functions to track held intersections
+// 10-19-26: Tracking fields are versioned with a seqlock so monitors can read them without the mutex
+// 10-19-26: The segment ends with a stats region (latency_stats.h); SHM_SEGMENT_SIZE is its only size
+// 10-19-26: shm_lock/shm_unlock wrap every intersection mutex and can profile contention
 #ifndef MEMORY_SEGMENTS_H
 #define MEMORY_SEGMENTS_H
 
 #include <pthread.h>
 #include <semaphore.h>
 #include <stddef.h>
+#include <time.h>
+#include "latency_stats.h"
 
 #define NUM_INTERSECTIONS 5
 #define MAX_TRAINS 10
@@ -22,6 +27,7 @@ typedef struct {
     char semName[32];
 
     //Resource tracking
+    unsigned int seq;               // seqlock version, odd while the fields below are being changed
     int held_count;                 // how many trains currently holding
     int holders[MAX_TRAINS];        // train IDs holding this intersection
 
@@ -35,19 +41,89 @@ typedef struct {
     int fakeHour;
 } SharedIntersection;
 
+// Consistent copy of one intersection's tracking fields, taken without its mutex
+typedef struct {
+    int capacity;
+    int held_count;
+    int holders[MAX_TRAINS];
+    int wait_count;
+    int wait_queue[MAX_TRAINS];
+} IntersectionSnapshot;
+
+
+// Segment layout: SharedIntersection[NUM_INTERSECTIONS], then RailStats on its own cache line
+#define SHM_STATS_OFFSET (((sizeof(SharedIntersection) * NUM_INTERSECTIONS) + 63) & ~(size_t)63)
+#define SHM_SEGMENT_SIZE (SHM_STATS_OFFSET + sizeof(RailStats))
+
+static inline RailStats *shm_stats(const SharedIntersection *base) {
+    return base ? (RailStats *)((char *)base + SHM_STATS_OFFSET) : NULL;
+}
+
+// Take and drop the mutex of shared[idx]. site says who is asking (LOCK_SITE_*).
+// With lock_profiling off this is one extra load; with it on the lock is tried first,
+// and acquisitions, blocked acquisitions, wait and hold time go to the stats region.
+// shared must be the start of a full segment (SHM_SEGMENT_SIZE), not a bare array.
+static inline uint64_t shm_lock_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void shm_lock(SharedIntersection *shared, int idx, int site) {
+    RailStats *stats = shm_stats(shared);
+    if (!__atomic_load_n(&stats->lock_profiling, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&shared[idx].mutex);
+        return;
+    }
+    LockStats *ls = &stats->locks[idx][site];
+    uint64_t now;
+    if (pthread_mutex_trylock(&shared[idx].mutex) == 0) {
+        now = shm_lock_now_ns();
+    } else {
+        uint64_t start = shm_lock_now_ns();
+        pthread_mutex_lock(&shared[idx].mutex);
+        now = shm_lock_now_ns();
+        __atomic_fetch_add(&ls->contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&ls->wait_ns, now - start, __ATOMIC_RELAXED);
+        stats_max(&ls->wait_max_ns, now - start);
+    }
+    __atomic_fetch_add(&ls->acquisitions, 1, __ATOMIC_RELAXED);
+    ls->hold_start_ns = now;
+}
+
+static inline void shm_unlock(SharedIntersection *shared, int idx, int site) {
+    RailStats *stats = shm_stats(shared);
+    if (__atomic_load_n(&stats->lock_profiling, __ATOMIC_RELAXED)) {
+        LockStats *ls = &stats->locks[idx][site];
+        if (ls->hold_start_ns) {
+            uint64_t held = shm_lock_now_ns() - ls->hold_start_ns;
+            ls->hold_start_ns = 0;
+            __atomic_fetch_add(&ls->hold_ns, held, __ATOMIC_RELAXED);
+            stats_max(&ls->hold_max_ns, held);
+        }
+    }
+    pthread_mutex_unlock(&shared[idx].mutex);
+}
 
 // extern makes array global to all files in codebase
 extern SharedIntersection *shared_intersections; 
 
 // Function declarations
 SharedIntersection* init_shared_memory(const char *shm_name, size_t *shm_size);
+SharedIntersection* attach_shared_memory(const char *shm_name, size_t *shm_size); // read-only, for monitors
 void destroy_shared_memory(SharedIntersection *shared_intersections, const char *shm_name, size_t shm_size);
 
 // Functions for tracking
 int  add_holder     (SharedIntersection *shared, int idx, int train_id);
 int  remove_holder  (SharedIntersection *shared, int idx, int train_id);
-void enqueue_waiter (SharedIntersection *shared, int idx, int train_id);
+int  enqueue_waiter (SharedIntersection *shared, int idx, int train_id);
 int  dequeue_waiter (SharedIntersection *shared, int idx);
+int  remove_waiter  (SharedIntersection *shared, int idx, int train_id);
+int  has_capacity   (SharedIntersection *shared, int idx);
+void set_capacity   (SharedIntersection *shared, int idx, int capacity);
+
+// Lock-free read of holders/waiters. Returns 1 on success, 0 if writers kept it busy
+int  snapshot_intersection(const SharedIntersection *shared, int idx, IntersectionSnapshot *out);
 
 
 #endif // MEMORY_SEGMENTS_H
@@ -0,0 +1,125 @@
+// latency_stats.c
+// Group: B
+// Date: 10-19-2026
+// Reading side of the latency histograms and lock counters: bucket bounds, percentiles and the reports
+// the server prints at shutdown. Readers take relaxed loads, so a report taken while
+// the server runs can be a few events behind but never blocks it.
+#include "latency_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *kind_names[STAT_KINDS] = { "wait", "hold", "service" };
+
+const char *stats_kind_name(int kind) {
+    return (kind >= 0 && kind < STAT_KINDS) ? kind_names[kind] : "?";
+}
+
+void stats_set_name(RailStats *stats, int idx, const char *name) {
+    if (!stats || idx < 0 || idx >= STATS_MAX_INTERSECTIONS) return;
+    snprintf(stats->names[idx], STATS_NAME_LEN, "%s", name);
+    if (idx >= stats->intersection_count) stats->intersection_count = idx + 1;
+    stats->magic = RAIL_STATS_MAGIC;
+}
+
+uint64_t stats_bucket_value(int bucket) {
+    if (bucket < STATS_SUB_BUCKETS) return bucket;
+    int shift = bucket / STATS_SUB_BUCKETS - 1;
+    uint64_t sub = bucket % STATS_SUB_BUCKETS;
+    uint64_t lower = (STATS_SUB_BUCKETS + sub) << shift;
+    return lower + (((uint64_t)1 << shift) - 1);
+}
+
+uint64_t stats_percentile(const LatencyHistogram *h, double q) {
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(q * count + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t value = stats_bucket_value(b);
+            uint64_t max = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+            return value < max ? value : max;
+        }
+    }
+    return __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+}
+
+// ns in the most readable unit, e.g. "12.3us" or "1.02s"
+static void format_ns(char *out, size_t size, uint64_t ns) {
+    if (ns < 1000) snprintf(out, size, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(out, size, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) snprintf(out, size, "%.1fms", ns / 1e6);
+    else snprintf(out, size, "%.2fs", ns / 1e9);
+}
+
+void stats_print(FILE *out, const RailStats *stats) {
+    fprintf(out, "%-16s %-8s %8s %9s %9s %9s %9s %9s\n",
+            "intersection", "kind", "count", "mean", "p50", "p99", "p999", "max");
+    for (int i = 0; i < stats->intersection_count && i < STATS_MAX_INTERSECTIONS; i++) {
+        for (int k = 0; k < STAT_KINDS; k++) {
+            const LatencyHistogram *h = &stats->hist[i][k];
+            uint64_t count = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+            if (count == 0) continue;
+            char mean[16], p50[16], p99[16], p999[16], max[16];
+            format_ns(mean, sizeof(mean), __atomic_load_n(&h->sum_ns, __ATOMIC_RELAXED) / count);
+            format_ns(p50, sizeof(p50), stats_percentile(h, 0.50));
+            format_ns(p99, sizeof(p99), stats_percentile(h, 0.99));
+            format_ns(p999, sizeof(p999), stats_percentile(h, 0.999));
+            format_ns(max, sizeof(max), __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED));
+            fprintf(out, "%-16s %-8s %8llu %9s %9s %9s %9s %9s\n", stats->names[i],
+                    stats_kind_name(k), (unsigned long long)count, mean, p50, p99, p999, max);
+        }
+    }
+}
+
+static const char *site_names[LOCK_SITES] = { "tracking", "clock" };
+
+typedef struct {
+    int idx, site;
+    uint64_t wait_ns;
+} LockRank;
+
+static int by_wait_desc(const void *a, const void *b) {
+    const LockRank *x = a, *y = b;
+    return (x->wait_ns < y->wait_ns) - (x->wait_ns > y->wait_ns);
+}
+
+void stats_print_locks(FILE *out, const RailStats *stats) {
+    LockRank rank[STATS_MAX_INTERSECTIONS * LOCK_SITES];
+    int n = 0;
+    for (int i = 0; i < STATS_MAX_INTERSECTIONS; i++) {
+        for (int s = 0; s < LOCK_SITES; s++) {
+            const LockStats *ls = &stats->locks[i][s];
+            if (__atomic_load_n(&ls->acquisitions, __ATOMIC_RELAXED) == 0) continue;
+            rank[n].idx = i;
+            rank[n].site = s;
+            rank[n].wait_ns = __atomic_load_n(&ls->wait_ns, __ATOMIC_RELAXED);
+            n++;
+        }
+    }
+    qsort(rank, n, sizeof(rank[0]), by_wait_desc);
+
+    fprintf(out, "%-16s %-8s %10s %10s %7s %9s %9s %9s %9s\n", "mutex", "site", "acquired",
+            "contended", "cont%", "wait", "wait max", "hold avg", "hold max");
+    for (int r = 0; r < n; r++) {
+        const LockStats *ls = &stats->locks[rank[r].idx][rank[r].site];
+        uint64_t acq = __atomic_load_n(&ls->acquisitions, __ATOMIC_RELAXED);
+        uint64_t cont = __atomic_load_n(&ls->contended, __ATOMIC_RELAXED);
+        char wait[16], wait_max[16], hold_avg[16], hold_max[16];
+        format_ns(wait, sizeof(wait), rank[r].wait_ns);
+        format_ns(wait_max, sizeof(wait_max), __atomic_load_n(&ls->wait_max_ns, __ATOMIC_RELAXED));
+        format_ns(hold_avg, sizeof(hold_avg), __atomic_load_n(&ls->hold_ns, __ATOMIC_RELAXED) / acq);
+        format_ns(hold_max, sizeof(hold_max), __atomic_load_n(&ls->hold_max_ns, __ATOMIC_RELAXED));
+        const char *name = rank[r].idx < stats->intersection_count ? stats->names[rank[r].idx] : "(unused)";
+        fprintf(out, "%-16s %-8s %10llu %10llu %6.1f%% %9s %9s %9s %9s\n", name, site_names[rank[r].site],
+                (unsigned long long)acq, (unsigned long long)cont, 100.0 * cont / acq,
+                wait, wait_max, hold_avg, hold_max);
+    }
+    if (n == 0) fprintf(out, "(no lock activity recorded, is lock profiling on?)\n");
+}
+
+void stats_reset_locks(RailStats *stats) {
+    memset(stats->locks, 0, sizeof(stats->locks));
+}
@@ -0,0 +1,118 @@
+// latency_stats.h
+// Group: B
+// Date: 10-19-2026
+// Log-linear (HDR-style) latency histograms that live in the stats region of
+// /intersection_shm, right after the SharedIntersection array. Every power of two is
+// split into 16 linear buckets, so any recorded value is off by at most 1/16 (6.25%)
+// and a histogram covers 1 ns to centuries in under 1000 buckets. Updates are relaxed
+// atomic adds, so any process can read them live while the server records.
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define STATS_SUB_BITS     4
+#define STATS_SUB_BUCKETS  (1 << STATS_SUB_BITS)
+#define STATS_BUCKETS      ((64 - STATS_SUB_BITS + 1) * STATS_SUB_BUCKETS)
+#define STATS_MAX_INTERSECTIONS 8
+#define STATS_NAME_LEN     32
+
+// what is being timed, per intersection
+enum {
+    STAT_WAIT = 0,      // ACQUIRE (or ACQ_SET) arrived -> GRANT sent
+    STAT_HOLD,          // GRANT sent -> RELEASE arrived
+    STAT_SERVICE,       // server time spent on one request, receive -> reply
+    STAT_KINDS
+};
+
+// server-wide event counters, for rates (railstat)
+enum {
+    STAT_REQUESTS = 0,  // every message the server handled
+    STAT_GRANTS,        // immediate and deferred
+    STAT_WAITS,
+    STAT_RELEASES,
+    STAT_TIMEOUTS,
+    STAT_FAILS,
+    STAT_COUNTERS
+};
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[STATS_BUCKETS];
+} LatencyHistogram;
+
+// who takes a SharedIntersection mutex. Mutex 0 guards intersection 0 and the sim clock
+enum {
+    LOCK_SITE_TRACKING = 0,   // holders and wait queue (Memory_Segments.c)
+    LOCK_SITE_CLOCK,          // setFakeSec/getFakeTime, every process
+    LOCK_SITES
+};
+
+// contention of one mutex from one site, filled in by shm_lock/shm_unlock while
+// lock_profiling is set
+typedef struct {
+    uint64_t acquisitions;
+    uint64_t contended;       // trylock failed, had to block
+    uint64_t wait_ns;         // total time blocked
+    uint64_t wait_max_ns;
+    uint64_t hold_ns;         // total time held
+    uint64_t hold_max_ns;
+    uint64_t hold_start_ns;   // written by the current holder only
+} LockStats;
+
+typedef struct {
+    uint32_t magic;
+    int intersection_count;
+    char names[STATS_MAX_INTERSECTIONS][STATS_NAME_LEN];
+    uint64_t counters[STAT_COUNTERS];
+    LatencyHistogram hist[STATS_MAX_INTERSECTIONS][STAT_KINDS];
+    int lock_profiling;       // 0/1, can be flipped while running (raillocks on|off)
+    LockStats locks[STATS_MAX_INTERSECTIONS][LOCK_SITES];
+} RailStats;
+
+#define RAIL_STATS_MAGIC 0x52535441u   // "RSTA"
+
+static inline int stats_bucket(uint64_t v) {
+    if (v < STATS_SUB_BUCKETS) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - STATS_SUB_BITS;
+    return (msb - STATS_SUB_BITS + 1) * STATS_SUB_BUCKETS + (int)((v >> shift) - STATS_SUB_BUCKETS);
+}
+
+static inline void stats_max(uint64_t *max, uint64_t v) {
+    uint64_t cur = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(max, &cur, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// one value into one histogram, safe from any number of processes at once
+static inline void hist_record(LatencyHistogram *h, uint64_t ns) {
+    __atomic_fetch_add(&h->buckets[stats_bucket(ns)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_ns, ns, __ATOMIC_RELAXED);
+    stats_max(&h->max_ns, ns);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+}
+
+static inline void stats_record(RailStats *stats, int idx, int kind, uint64_t ns) {
+    if (!stats || idx < 0 || idx >= STATS_MAX_INTERSECTIONS) return;
+    hist_record(&stats->hist[idx][kind], ns);
+}
+
+static inline void stats_count(RailStats *stats, int counter) {
+    if (stats) __atomic_fetch_add(&stats->counters[counter], 1, __ATOMIC_RELAXED);
+}
+
+const char *stats_kind_name(int kind);
+void     stats_set_name(RailStats *stats, int idx, const char *name);
+uint64_t stats_bucket_value(int bucket);          // highest value that falls in the bucket
+uint64_t stats_percentile(const LatencyHistogram *h, double q);   // q in [0, 1]
+// one line per intersection and kind: count, mean, p50, p99, p999, max
+void     stats_print(FILE *out, const RailStats *stats);
+// every mutex and site that was taken, most time spent blocked first
+void     stats_print_locks(FILE *out, const RailStats *stats);
+void     stats_reset_locks(RailStats *stats);
+
+#endif // LATENCY_STATS_H
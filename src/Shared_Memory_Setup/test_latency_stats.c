@@ -0,0 +1,48 @@
+// test_latency_stats.c
+// Group: B
+// Date: 10-19-2026
+// Checks the log-linear bucket math and percentiles of latency_stats.
+// Not part of the main build. Compile and run from this directory:
+// gcc -Wall -o test_stats test_latency_stats.c latency_stats.c && ./test_stats
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "latency_stats.h"
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+int main(void) {
+    // every value lands in a bucket whose bounds hold it, within 1/16
+    for (uint64_t v = 1; v < ((uint64_t)1 << 62); v = v * 3 + 1) {
+        int b = stats_bucket(v);
+        uint64_t high = stats_bucket_value(b);
+        uint64_t low = b == 0 ? 0 : stats_bucket_value(b - 1) + 1;
+        check(b >= 0 && b < STATS_BUCKETS, "bucket in range");
+        check(v >= low && v <= high, "value inside its bucket");
+        check(high - low <= v / STATS_SUB_BUCKETS + 1, "bucket width within 1/16");
+    }
+    check(stats_bucket(UINT64_MAX) == STATS_BUCKETS - 1, "largest value uses the last bucket");
+
+    // 1..1000 us: percentiles within a bucket of the exact answer
+    static RailStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats_set_name(&stats, 0, "IntersectionA");
+    for (uint64_t us = 1; us <= 1000; us++) stats_record(&stats, 0, STAT_WAIT, us * 1000);
+    const LatencyHistogram *h = &stats.hist[0][STAT_WAIT];
+    uint64_t p50 = stats_percentile(h, 0.50), p99 = stats_percentile(h, 0.99);
+    check(h->count == 1000 && h->max_ns == 1000000, "count and max");
+    check(p50 >= 500000 && p50 <= 500000 + 500000 / 16, "p50 close to 500us");
+    check(p99 >= 990000 && p99 <= 1000000, "p99 close to 990us, capped by max");
+    check(stats_percentile(&stats.hist[0][STAT_HOLD], 0.5) == 0, "empty histogram");
+
+    stats_print(stdout, &stats);
+    printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+// chrome_trace.c
+// Group: B
+// Date: 10-19-2026
+// Spans are written as complete ("X") events when they end, so the server only keeps
+// the start time of each open wait and hold. Timestamps are CLOCK_MONOTONIC
+// microseconds since ctrace_open(); the sim clock goes into each event's args.
+#include "chrome_trace.h"
+#include "../Shared_Memory_Setup/Memory_Segments.h" // fake clock
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PID_INTERSECTIONS 1
+#define PID_TRAINS        2
+
+static int ctrace_fd = -1;
+static char buf[CTRACE_BUF_SIZE];
+static size_t buf_len = 0;
+static int first_event = 1;
+static struct timespec origin;
+
+static char names[CTRACE_MAX_INTERSECTIONS][64];   // kept JSON-escaped, printed as is
+
+typedef struct {
+    double start_us;       // < 0 when nothing is open
+    int start_sim;
+    int idx;
+} OpenSpan;
+
+static OpenSpan waits[CTRACE_MAX_TRAINS + 1];
+static OpenSpan holds[CTRACE_MAX_INTERSECTIONS][CTRACE_MAX_TRAINS + 1];
+static int train_named[CTRACE_MAX_TRAINS + 1];
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec - origin.tv_sec) * 1e6 + (ts.tv_nsec - origin.tv_nsec) / 1e3;
+}
+
+static int sim_now(void) {
+    return shared_intersections
+        ? __atomic_load_n(&shared_intersections[0].fakeSec, __ATOMIC_RELAXED) : 0;
+}
+
+// copies name into out with ", \ and control characters escaped for a JSON string;
+// cuts at a character boundary so an escape is never split
+static void json_escape(char *out, size_t size, const char *name) {
+    size_t o = 0;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        char esc[7];
+        size_t n;
+        if (*p == '"' || *p == '\\') n = snprintf(esc, sizeof(esc), "\\%c", *p);
+        else if (*p < 0x20) n = snprintf(esc, sizeof(esc), "\\u%04x", *p);
+        else { esc[0] = *p; n = 1; }
+        if (o + n >= size) break;
+        memcpy(out + o, esc, n);
+        o += n;
+    }
+    out[o] = '\0';
+}
+
+static void flush_buf(void) {
+    size_t off = 0;
+    while (off < buf_len) {
+        ssize_t n = write(ctrace_fd, buf + off, buf_len - off);
+        if (n <= 0) {
+            perror("chrome trace write");
+            break;
+        }
+        off += n;
+    }
+    buf_len = 0;
+}
+
+// appends one event object, separated from the previous one
+static void emit(const char *fmt, ...) {
+    if (buf_len > CTRACE_BUF_SIZE - 512) flush_buf();
+    if (!first_event) buf[buf_len++] = ',';
+    first_event = 0;
+    buf[buf_len++] = '\n';
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + buf_len, CTRACE_BUF_SIZE - buf_len, fmt, args);
+    va_end(args);
+    if (n > 0) buf_len += (size_t)n < CTRACE_BUF_SIZE - buf_len ? (size_t)n : CTRACE_BUF_SIZE - buf_len - 1;
+}
+
+static int valid_train(int train_id) {
+    return ctrace_fd >= 0 && train_id >= 0 && train_id <= CTRACE_MAX_TRAINS;
+}
+
+static int valid_idx(int idx) {
+    return idx >= 0 && idx < CTRACE_MAX_INTERSECTIONS;
+}
+
+int ctrace_open(const char *path) {
+    ctrace_fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0666);
+    if (ctrace_fd < 0) {
+        perror("chrome trace open");
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &origin);
+    for (int t = 0; t <= CTRACE_MAX_TRAINS; t++) {
+        waits[t].start_us = -1;
+        train_named[t] = 0;
+        for (int i = 0; i < CTRACE_MAX_INTERSECTIONS; i++) holds[i][t].start_us = -1;
+    }
+    first_event = 1;
+    const char *head = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    buf_len = strlen(head);
+    memcpy(buf, head, buf_len);
+    emit("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"Intersections\"}}",
+         PID_INTERSECTIONS);
+    emit("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"Trains\"}}", PID_TRAINS);
+    return 0;
+}
+
+void ctrace_name_intersection(int idx, const char *name) {
+    if (ctrace_fd < 0 || !valid_idx(idx)) return;
+    json_escape(names[idx], sizeof(names[idx]), name);
+    emit("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+         PID_INTERSECTIONS, idx + 1, names[idx]);
+}
+
+void ctrace_wait_begin(int train_id, int idx) {
+    if (!valid_train(train_id)) return;
+    if (!train_named[train_id]) {
+        emit("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"Train %d\"}}",
+             PID_TRAINS, train_id, train_id);
+        train_named[train_id] = 1;
+    }
+    waits[train_id].start_us = now_us();
+    waits[train_id].start_sim = sim_now();
+    waits[train_id].idx = idx;
+}
+
+void ctrace_wait_end(int train_id, const char *outcome) {
+    if (!valid_train(train_id) || waits[train_id].start_us < 0) return;
+    OpenSpan *w = &waits[train_id];
+    int idx = valid_idx(w->idx) ? w->idx : 0;
+    emit("{\"ph\":\"X\",\"cat\":\"wait\",\"name\":\"wait %s\",\"pid\":%d,\"tid\":%d,"
+         "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"outcome\":\"%s\",\"sim_start\":%d,\"sim_end\":%d}}",
+         names[idx], PID_TRAINS, train_id, w->start_us, now_us() - w->start_us,
+         outcome, w->start_sim, sim_now());
+    w->start_us = -1;
+}
+
+void ctrace_grant(int train_id, const int idx[], int count) {
+    if (!valid_train(train_id)) return;
+    ctrace_wait_end(train_id, "GRANT");
+    double ts = now_us();
+    int sim = sim_now();
+    for (int i = 0; i < count; i++) {
+        if (!valid_idx(idx[i])) continue;
+        holds[idx[i]][train_id].start_us = ts;
+        holds[idx[i]][train_id].start_sim = sim;
+    }
+}
+
+void ctrace_release(int train_id, int idx) {
+    if (!valid_train(train_id) || !valid_idx(idx)) return;
+    OpenSpan *h = &holds[idx][train_id];
+    if (h->start_us < 0) return;
+    emit("{\"ph\":\"X\",\"cat\":\"hold\",\"name\":\"Train %d\",\"pid\":%d,\"tid\":%d,"
+         "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"sim_start\":%d,\"sim_end\":%d}}",
+         train_id, PID_INTERSECTIONS, idx + 1, h->start_us, now_us() - h->start_us,
+         h->start_sim, sim_now());
+    h->start_us = -1;
+}
+
+void ctrace_close(void) {
+    if (ctrace_fd < 0) return;
+    // spans still open at shutdown end here so they are not lost
+    for (int t = 0; t <= CTRACE_MAX_TRAINS; t++) {
+        ctrace_wait_end(t, "OPEN");
+        for (int i = 0; i < CTRACE_MAX_INTERSECTIONS; i++) ctrace_release(t, i);
+    }
+    if (buf_len > CTRACE_BUF_SIZE - 8) flush_buf();
+    memcpy(buf + buf_len, "\n]}\n", 4);
+    buf_len += 4;
+    flush_buf();
+    close(ctrace_fd);
+    ctrace_fd = -1;
+}
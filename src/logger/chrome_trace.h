@@ -0,0 +1,27 @@
+// chrome_trace.h
+// Group: B
+// Date: 10-19-2026
+// Optional Chrome Trace Event export from the server (load the file in chrome://tracing
+// or ui.perfetto.dev). One track per intersection shows who occupied it (GRANT to
+// RELEASE), one track per train shows how long it waited (ACQUIRE to GRANT or TIMEOUT).
+// Events are formatted into an in-memory buffer that is written out in large chunks.
+//
+// Off unless ctrace_open() is called; the server calls it when RAIL_CHROME_TRACE names
+// an output file. Every call is a no-op while it is off.
+#ifndef CHROME_TRACE_H
+#define CHROME_TRACE_H
+
+#define CTRACE_MAX_TRAINS        64
+#define CTRACE_MAX_INTERSECTIONS 64
+#define CTRACE_BUF_SIZE          (64 * 1024)
+
+int  ctrace_open(const char *path);
+void ctrace_close(void);                                   // writes the rest and the closing bracket
+void ctrace_name_intersection(int idx, const char *name);   // track label
+
+void ctrace_wait_begin(int train_id, int idx);             // ACQUIRE or ACQ_SET arrived
+void ctrace_grant(int train_id, const int idx[], int count);  // ends the wait, starts holds
+void ctrace_wait_end(int train_id, const char *outcome);   // TIMEOUT or FAIL, no hold follows
+void ctrace_release(int train_id, int idx);                // ends one hold
+
+#endif // CHROME_TRACE_H
@@ -5,12 +5,14 @@ Email: jarett.woodard@okstate.edu
 Date: 4.12.2025
 */
 
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200112L
 #include "csv_logger.h"
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <signal.h>
+#include <pthread.h>
 #include "../Shared_Memory_Setup/Memory_Segments.h"
 #include "../parser/parser.h"
 
@@ -74,6 +76,189 @@ void validate_csv_log_data(CsvLogData* log_data) {
 // Declare csv_file as a static variable
 static FILE* csv_file = NULL;
 
+/*
+Buffered mode (default). Rows are built by hand into one large buffer and
+written with a single write() once it is nearly full, once a second, and on
+close, exit, SIGINT or SIGTERM. The once a second is kept by a flusher thread,
+so rows still reach the file when no more rows come (a quiet or wedged run). The "YYYY-MM-DD HH:MM:SS." prefix only
+changes once a second, so localtime/strftime run once per second instead of
+once per row. csv_logger_set_buffered(false) goes back to one fprintf and
+fflush per row.
+*/
+#define CSV_BUF_SIZE (256 * 1024)
+#define CSV_ROW_MAX 4096                  // flush early so a row always fits
+#define CSV_FLUSH_INTERVAL_SEC 1
+
+static char csv_buf[CSV_BUF_SIZE];
+static size_t csv_len = 0;
+static time_t csv_last_flush = 0;
+static bool csv_buffered = true;
+static pthread_mutex_t csv_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static time_t cached_sec = -1;
+static char cached_prefix[32];            // date and time up to the '.'
+static size_t cached_prefix_len = 0;
+
+// writes out the buffer. Only uses write(), so the signal handler can call it too
+static void csv_write_buffer(void) {
+    size_t off = 0;
+    while (off < csv_len) {
+        ssize_t n = write(fileno(csv_file), csv_buf + off, csv_len - off);
+        if (n <= 0) break;
+        off += n;
+    }
+    csv_len = 0;
+}
+
+static pthread_t csv_flusher;
+static pid_t csv_flusher_owner = 0;      // the process the thread runs in, 0 = none
+static bool csv_flusher_stop = false;
+static pthread_cond_t csv_flusher_wake;
+
+// writes out rows that have waited CSV_FLUSH_INTERVAL_SEC with nothing after them
+static void *csv_flush_loop(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&csv_lock);
+    while (!csv_flusher_stop) {
+        struct timespec until;
+        clock_gettime(CLOCK_MONOTONIC, &until);
+        until.tv_sec += CSV_FLUSH_INTERVAL_SEC;
+        pthread_cond_timedwait(&csv_flusher_wake, &csv_lock, &until);
+        time_t now = time(NULL);
+        if (csv_file && csv_len > 0 && now - csv_last_flush >= CSV_FLUSH_INTERVAL_SEC) {
+            csv_write_buffer();
+            csv_last_flush = now;
+        }
+    }
+    pthread_mutex_unlock(&csv_lock);
+    return NULL;
+}
+
+static void csv_start_flusher(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&csv_flusher_wake, &attr);
+    pthread_condattr_destroy(&attr);
+    csv_flusher_stop = false;
+    // without it rows still go out with the next row, when full, and on exit
+    if (pthread_create(&csv_flusher, NULL, csv_flush_loop, NULL) == 0) csv_flusher_owner = getpid();
+}
+
+static void csv_stop_flusher(void) {
+    if (csv_flusher_owner != getpid()) return; // a forked child does not have the thread
+    pthread_mutex_lock(&csv_lock);
+    csv_flusher_stop = true;
+    pthread_cond_signal(&csv_flusher_wake);
+    pthread_mutex_unlock(&csv_lock);
+    pthread_join(csv_flusher, NULL);
+    csv_flusher_owner = 0;
+}
+
+void csv_logger_flush(void) {
+    if (!csv_file) return;
+    pthread_mutex_lock(&csv_lock);
+    csv_write_buffer();
+    pthread_mutex_unlock(&csv_lock);
+}
+
+static void csv_flush_on_signal(int sig) {
+    if (csv_file) csv_write_buffer();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+void csv_logger_set_buffered(bool buffered) {
+    csv_logger_flush();
+    csv_buffered = buffered;
+}
+
+// refreshes the cached date prefix when the wall-clock second changes
+static void cache_prefix(time_t sec) {
+    if (sec == cached_sec) return;
+    struct tm tm_info;
+    localtime_r(&sec, &tm_info);
+    cached_prefix_len = strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S.", &tm_info);
+    cached_sec = sec;
+}
+
+// hand-rolled appenders, each one stops at the end of the buffer
+static inline void put_str(const char *str) {
+    size_t room = CSV_BUF_SIZE - csv_len;
+    size_t len = strlen(str);
+    if (len > room) len = room;
+    memcpy(csv_buf + csv_len, str, len);
+    csv_len += len;
+}
+
+static inline void put_char(char c) {
+    if (csv_len < CSV_BUF_SIZE) csv_buf[csv_len++] = c;
+}
+
+static inline void put_int(long value) {
+    char digits[24];
+    int n = 0;
+    unsigned long v = value < 0 ? -(unsigned long)value : (unsigned long)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0) put_char('-');
+    while (n > 0) put_char(digits[--n]);
+}
+
+static inline void put_nanos(long nsec) {
+    char digits[9];
+    for (int i = 8; i >= 0; i--) {
+        digits[i] = (char)('0' + nsec % 10);
+        nsec /= 10;
+    }
+    if (csv_len + 9 <= CSV_BUF_SIZE) {
+        memcpy(csv_buf + csv_len, digits, 9);
+        csv_len += 9;
+    }
+}
+
+// same row as the fprintf path, built directly in csv_buf
+static void append_row(const struct timespec *ts, const char *calling_file, const char *calling_func,
+                       const CsvLogData *d) {
+    cache_prefix(ts->tv_sec);
+    put_str(cached_prefix);
+    put_nanos(ts->tv_nsec);
+    put_char(','); put_str(calling_file);
+    put_char(','); put_str(calling_func);
+    put_char(','); put_int(d->train_id);
+    put_char(','); put_str(d->intersection_id);
+    put_char(','); put_str(d->action);
+    put_char(','); put_str(d->status);
+    put_char(','); put_int(d->pid);
+    put_char(','); put_str(d->error_msg);
+    put_char(',');
+    if (d->resource_state) {
+        const SharedIntersection *si = d->resource_state;
+        put_str("{\"holders_count\":"); put_int(si->held_count);
+        put_str(";\"wait_count\":"); put_int(si->wait_count);
+        put_str(";\"lock_type\":\""); put_str(si->capacity == 1 ? "MUTEX" : "SEMAPHORE");
+        put_str("\";\"sem_name\":\""); put_str(si->semName);
+        put_str("\"}");
+    } else {
+        put_str("{}");
+    }
+    put_char(','); put_str(d->has_deadlock ? "true" : "false");
+    put_char(',');
+    if (d->train_state) {
+        put_str("{\"route_length\":"); put_int(d->train_state->routeLength);
+        put_str(";\"position\":"); put_int(d->current_position);
+        put_char('}');
+    } else {
+        put_str("{}");
+    }
+    put_char(','); put_int(d->node_count);
+    put_char(','); put_str(d->cycle_path);
+    put_char(','); put_str(d->edge_type);
+    put_char('\n');
+}
+
 FILE* csv_logger_init(void) {
     if (csv_file != NULL) {
         return csv_file; // Already initialized
@@ -98,6 +283,23 @@ FILE* csv_logger_init(void) {
     fprintf(csv_file, "sys_time,calling_file,calling_function,train_id,intersection_id,action,status,pid,error_msg,resource_state,has_deadlock,train_state,node_count,cycle_path,edge_type\n");
     fflush(csv_file);
 
+    // buffered rows must survive a normal exit or Ctrl-C
+    static bool hooks_installed = false;
+    if (!hooks_installed) {
+        atexit(csv_logger_flush);
+        int sigs[] = { SIGINT, SIGTERM };
+        for (int i = 0; i < 2; i++) {
+            struct sigaction old;
+            // leave handlers someone else installed alone
+            if (sigaction(sigs[i], NULL, &old) == 0 && old.sa_handler == SIG_DFL) {
+                signal(sigs[i], csv_flush_on_signal);
+            }
+        }
+        hooks_installed = true;
+    }
+    csv_last_flush = now;
+    csv_start_flusher();
+
     return csv_file;
 }
 
@@ -126,6 +328,17 @@ int LOG_CSV_impl(const char* calling_file, const char* calling_func, int train_i
     struct timespec ts;
     clock_gettime(CLOCK_REALTIME, &ts);
 
+    if (csv_buffered) {
+        pthread_mutex_lock(&csv_lock);
+        append_row(&ts, calling_file, calling_func, &log_data);
+        if (csv_len > CSV_BUF_SIZE - CSV_ROW_MAX || ts.tv_sec - csv_last_flush >= CSV_FLUSH_INTERVAL_SEC) {
+            csv_write_buffer();
+            csv_last_flush = ts.tv_sec;
+        }
+        pthread_mutex_unlock(&csv_lock);
+        return 0;
+    }
+
     // timestamp format, high precision
     char precise_time[32];
     struct tm *tm_info = localtime(&ts.tv_sec);
@@ -189,6 +402,8 @@ int log_train_event_csv(FILE* file, const char* csv_data, const char* calling_fi
 }
 
 void csv_logger_close(void) {
+    csv_stop_flusher();
+    csv_logger_flush();
     if (csv_file) {
         fclose(csv_file);
         csv_file = NULL;
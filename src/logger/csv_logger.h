@@ -111,6 +111,13 @@ int LOG_CSV_impl(const char* calling_file,
 int log_train_event_csv(FILE* file, const char* csv_data, 
                        const char* calling_file, const char* calling_func);
 
+// Rows are buffered and written in large chunks by default (flushed when the buffer is
+// nearly full, every second by a background thread even if no rows arrive, and on
+// close, exit, SIGINT or SIGTERM).
+// Pass false to write and fflush every row immediately instead.
+void csv_logger_set_buffered(bool buffered);
+void csv_logger_flush(void);
+
 void csv_logger_close(void);
 
 #endif // CSV_LOGGER_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+// flight_recorder.c
+// Group: B
+// Date: 10-19-2026
+// Shared memory rings for the flight recorder. A process claims a ring by swapping its
+// pid into a free slot (or the slot of a process that no longer exists) and is then the
+// only writer of that ring. Readers copy whatever is there; an event being overwritten
+// at that moment can come out mixed, which is fine for a diagnostic dump.
+#include "flight_recorder.h"
+#include "trace.h"            // opcode and result names
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+FlightRegion *flight_region = NULL;
+FlightRing *flight_ring = NULL;
+static int flight_owner = 0;          // this process created the segment
+static int atfork_registered = 0;
+
+// a forked child shares the region but must claim its own ring
+static void flight_after_fork_child(void) {
+    flight_ring = NULL;
+    flight_owner = 0;
+}
+
+static FlightRegion *map_region(int flags, int prot) {
+    int fd = shm_open(FLIGHT_SHM_NAME, flags, 0666);
+    if (fd == -1) return NULL;
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(FlightRegion)) == -1) {
+        perror("flight ftruncate");
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(FlightRegion), prot, MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static int claim_ring(const char *role) {
+    pid_t me = getpid();
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < FLIGHT_MAX_PROCS; i++) {
+            FlightRing *ring = &flight_region->rings[i];
+            pid_t owner = __atomic_load_n(&ring->pid, __ATOMIC_ACQUIRE);
+            // first pass takes free slots, the second reuses rings of dead processes
+            if (pass == 0 && owner != 0) continue;
+            if (pass == 1 && (owner == 0 || kill(owner, 0) == 0 || errno != ESRCH)) continue;
+            if (!__atomic_compare_exchange_n(&ring->pid, &owner, me, 0,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                continue;
+            }
+            snprintf(ring->role, sizeof(ring->role), "%s", role);
+            __atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+            flight_ring = ring;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int flight_create(void) {
+    shm_unlink(FLIGHT_SHM_NAME); // rings from an earlier run
+    flight_region = map_region(O_CREAT | O_RDWR, PROT_READ | PROT_WRITE);
+    if (!flight_region) {
+        perror("flight shm_open");
+        return -1;
+    }
+    memset(flight_region, 0, sizeof(FlightRegion));
+    flight_region->magic = FLIGHT_MAGIC;
+    flight_owner = 1;
+    return flight_attach("server");
+}
+
+int flight_attach(const char *role) {
+    if (!atfork_registered) {
+        pthread_atfork(NULL, NULL, flight_after_fork_child);
+        atfork_registered = 1;
+    }
+    if (!flight_region) {
+        flight_region = map_region(O_RDWR, PROT_READ | PROT_WRITE);
+        if (!flight_region) return -1; // no server running, recorder stays off
+    }
+    if (flight_region->magic != FLIGHT_MAGIC) return -1;
+    return claim_ring(role);
+}
+
+void flight_set_name(int idx, const char *name) {
+    if (!flight_region || idx < 0 || idx >= NUM_INTERSECTIONS) return;
+    snprintf(flight_region->names[idx], sizeof(flight_region->names[idx]), "%s", name);
+    if (idx >= flight_region->intersection_count) flight_region->intersection_count = idx + 1;
+}
+
+void flight_destroy(void) {
+    if (!flight_region) return;
+    munmap(flight_region, sizeof(FlightRegion));
+    if (flight_owner) shm_unlink(FLIGHT_SHM_NAME);
+    flight_region = NULL;
+    flight_ring = NULL;
+    flight_owner = 0;
+}
+
+FlightRegion *flight_open_readonly(void) {
+    FlightRegion *region = map_region(O_RDONLY, PROT_READ);
+    if (region && region->magic != FLIGHT_MAGIC) {
+        munmap(region, sizeof(FlightRegion));
+        return NULL;
+    }
+    return region;
+}
+
+typedef struct {
+    FlightEvent event;
+    int ring;
+} DumpEntry;
+
+static int by_sim_time(const void *a, const void *b) {
+    const FlightEvent *x = &((const DumpEntry *)a)->event;
+    const FlightEvent *y = &((const DumpEntry *)b)->event;
+    if (x->sim_tick != y->sim_tick) return x->sim_tick < y->sim_tick ? -1 : 1;
+    if (x->wall_ns != y->wall_ns) return x->wall_ns < y->wall_ns ? -1 : 1;
+    return 0;
+}
+
+void flight_dump(FILE *out, const FlightRegion *region, const SharedIntersection *shared) {
+    DumpEntry *entries = malloc(sizeof(DumpEntry) * FLIGHT_MAX_PROCS * FLIGHT_RING_EVENTS);
+    if (!entries) {
+        perror("flight_dump malloc");
+        return;
+    }
+    int count = 0;
+    for (int r = 0; r < FLIGHT_MAX_PROCS; r++) {
+        const FlightRing *ring = &region->rings[r];
+        if (__atomic_load_n(&ring->pid, __ATOMIC_ACQUIRE) == 0) continue;
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t n = head < FLIGHT_RING_EVENTS ? head : FLIGHT_RING_EVENTS;
+        for (uint64_t k = head - n; k < head; k++) {
+            entries[count].event = ring->events[k & (FLIGHT_RING_EVENTS - 1)];
+            entries[count].event.intersection[FLIGHT_NAME_LEN - 1] = '\0';
+            entries[count].ring = r;
+            count++;
+        }
+    }
+    qsort(entries, count, sizeof(DumpEntry), by_sim_time);
+
+    fprintf(out, "# flight recorder: %d events\n", count);
+    for (int i = 0; i < count; i++) {
+        const FlightEvent *e = &entries[i].event;
+        const FlightRing *ring = &region->rings[entries[i].ring];
+        unsigned t = e->sim_tick;
+        fprintf(out, "[%02u:%02u:%02u] %s(%d): TRAIN%u %s %s", t / 3600, (t % 3600) / 60, t % 60,
+                ring->role, (int)ring->pid, e->train_id, trace_op_name(e->opcode), e->intersection);
+        if (e->result) fprintf(out, " -> %s", trace_result_name(e->result));
+        fputc('\n', out);
+    }
+    free(entries);
+
+    if (!shared) return;
+    fprintf(out, "# intersections\n");
+    for (int i = 0; i < region->intersection_count; i++) {
+        IntersectionSnapshot snap;
+        if (!snapshot_intersection(shared, i, &snap)) {
+            fprintf(out, "%s: busy, no consistent read\n", region->names[i]);
+            continue;
+        }
+        fprintf(out, "%s (capacity %d): holders", region->names[i], snap.capacity);
+        for (int h = 0; h < snap.held_count; h++) fprintf(out, " %d", snap.holders[h]);
+        fprintf(out, "; waiting");
+        for (int w = 0; w < snap.wait_count; w++) fprintf(out, " %d", snap.wait_queue[w]);
+        fputc('\n', out);
+    }
+}
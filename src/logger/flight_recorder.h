@@ -0,0 +1,88 @@
+// flight_recorder.h
+// Group: B
+// Date: 10-19-2026
+// Always-on flight recorder. Every process owns one ring of its last FLIGHT_RING_EVENTS
+// events in the /rail_flight shared memory segment, next to /intersection_shm. Only the
+// owner writes its ring, so recording is a few plain stores and one release store of
+// the head, no locks. A SIGUSR1 to the server, or tools/raildump from any shell, prints
+// all rings merged by sim time together with the current holders and wait queues.
+// The segment outlives a crashed process, so raildump still works after a crash.
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+
+#define FLIGHT_SHM_NAME     "/rail_flight"
+#define FLIGHT_MAGIC        0x52464c32u   // "RFL2", the FlightEvent layout with 32-bit train ids
+#define FLIGHT_MAX_PROCS    32            // server, train_sim and its trains
+#define FLIGHT_RING_EVENTS  256           // power of two
+#define FLIGHT_NAME_LEN     16
+
+typedef struct {
+    uint64_t wall_ns;
+    uint32_t sim_tick;
+    uint32_t train_id;                    // 0 = server/system, else the N of TrainN
+    uint8_t  opcode;                      // TRACE_OP_*
+    uint8_t  result;                      // TRACE_RES_*
+    uint8_t  pad[2];
+    char     intersection[FLIGHT_NAME_LEN];
+} FlightEvent;
+
+_Static_assert(sizeof(FlightEvent) == 40, "raildump reads FlightEvents another process wrote");
+
+typedef struct {
+    pid_t    pid;                         // 0 = free slot
+    char     role[FLIGHT_NAME_LEN];
+    uint64_t head;                        // events ever written, the newest is head-1
+    FlightEvent events[FLIGHT_RING_EVENTS];
+} FlightRing;
+
+typedef struct {
+    uint32_t magic;
+    int      intersection_count;
+    char     names[NUM_INTERSECTIONS][32]; // set by the server, for the dump
+    FlightRing rings[FLIGHT_MAX_PROCS];
+} FlightRegion;
+
+extern FlightRegion *flight_region;
+extern FlightRing *flight_ring;           // this process's ring, NULL if none
+
+// server: create (or reset) the segment. Others: attach and claim a ring
+int  flight_create(void);
+int  flight_attach(const char *role);
+void flight_destroy(void);                // server, at a clean exit
+void flight_set_name(int idx, const char *name);
+
+// read-only mapping for raildump
+FlightRegion *flight_open_readonly(void);
+
+// every ring merged by sim time, then holders and waiters of each intersection
+void flight_dump(FILE *out, const FlightRegion *region, const SharedIntersection *shared);
+
+static inline void flight_record(int train_id, const char *intersection, int op, int result) {
+    FlightRing *ring = flight_ring;
+    if (!ring) return;
+    uint64_t n = ring->head;
+    FlightEvent *e = &ring->events[n & (FLIGHT_RING_EVENTS - 1)];
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    e->wall_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    e->sim_tick = shared_intersections
+        ? (uint32_t)__atomic_load_n(&shared_intersections[0].fakeSec, __ATOMIC_RELAXED) : 0;
+    e->train_id = (uint32_t)train_id;
+    e->opcode = (uint8_t)op;
+    e->result = (uint8_t)result;
+    int i = 0;
+    if (intersection) {
+        for (; i < FLIGHT_NAME_LEN - 1 && intersection[i]; i++) e->intersection[i] = intersection[i];
+    }
+    e->intersection[i] = '\0';
+    __atomic_store_n(&ring->head, n + 1, __ATOMIC_RELEASE);
+}
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,237 @@
+// log_queue.c
+// Group: B
+// Date: 10-19-2026
+// Shared memory log rings and the sim-time merge. Producers only touch their own ring's
+// head and the aggregator only touches tails, so neither side takes a lock.
+//
+// Shutdown: the aggregator sets closing, drains every ring one last time and sets done.
+// A producer that publishes and then sees closing waits for done and writes whatever
+// the final pass did not take itself, so no line is lost or written twice.
+#include "log_queue.h"
+#include "../Shared_Memory_Setup/Memory_Segments.h" // fake clock
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#define LOGQ_BATCH 64   // lines per writev()
+
+static LogqRegion *region = NULL;
+static LogqRing *my_ring = NULL;
+static int aggregator = 0;
+
+// merge scratch, only used by the aggregator thread
+typedef struct {
+    const LogqRecord *rec;
+} LogqPick;
+static LogqPick picks[LOGQ_PRODUCERS * LOGQ_SLOTS];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static LogqRegion *map_region(int flags) {
+    int fd = shm_open(LOGQ_SHM_NAME, flags, 0666);
+    if (fd == -1) return NULL;
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(LogqRegion)) == -1) {
+        perror("logq ftruncate");
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(LogqRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+int logq_create(void) {
+    shm_unlink(LOGQ_SHM_NAME);
+    region = map_region(O_CREAT | O_RDWR);
+    if (!region) {
+        perror("logq shm_open");
+        return -1;
+    }
+    memset(region, 0, sizeof(LogqRegion));
+    region->aggregator_pid = getpid();
+    __atomic_store_n(&region->magic, LOGQ_MAGIC, __ATOMIC_RELEASE);
+    aggregator = 1;
+    return 0;
+}
+
+int logq_attach(void) {
+    if (!region) region = map_region(O_RDWR);
+    if (!region) return -1;
+    if (__atomic_load_n(&region->magic, __ATOMIC_ACQUIRE) != LOGQ_MAGIC ||
+        __atomic_load_n(&region->done, __ATOMIC_ACQUIRE)) {
+        munmap(region, sizeof(LogqRegion));
+        region = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void logq_after_fork_child(void) {
+    my_ring = NULL;
+    aggregator = 0;
+}
+
+// a free ring, or one left fully drained by a process that has exited
+static LogqRing *claim_ring(void) {
+    pid_t me = getpid();
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < LOGQ_PRODUCERS; i++) {
+            LogqRing *ring = &region->rings[i];
+            pid_t owner = __atomic_load_n(&ring->pid, __ATOMIC_ACQUIRE);
+            if (pass == 0 && owner != 0) continue;
+            if (pass == 1) {
+                if (owner == 0 || kill(owner, 0) == 0 || errno != ESRCH) continue;
+                if (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) !=
+                    __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) continue;
+            }
+            if (__atomic_compare_exchange_n(&ring->pid, &owner, me, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                return ring;
+            }
+        }
+    }
+    return NULL;
+}
+
+// after the aggregator's final pass: write what it did not take, in order
+static void flush_own_ring(int fd) {
+    while (!__atomic_load_n(&region->done, __ATOMIC_ACQUIRE)) sched_yield();
+    uint64_t tail = __atomic_load_n(&my_ring->tail, __ATOMIC_ACQUIRE);
+    uint64_t head = my_ring->head;
+    for (; tail < head; tail++) {
+        const LogqRecord *r = &my_ring->slots[tail & (LOGQ_SLOTS - 1)];
+        if (fd >= 0 && write(fd, r->text, r->len) < 0) break;
+    }
+    __atomic_store_n(&my_ring->tail, head, __ATOMIC_RELEASE);
+}
+
+int logq_publish(const char *line, int len, int block, int fallback_fd) {
+    if (!region || __atomic_load_n(&region->done, __ATOMIC_ACQUIRE)) return -1;
+    if (!my_ring) {
+        my_ring = claim_ring();
+        if (!my_ring) return -1;
+    }
+    int cut = len > LOGQ_RECORD_MAX;
+    if (cut) len = LOGQ_RECORD_MAX;
+
+    uint64_t head = my_ring->head;
+    for (int spins = 1; head - __atomic_load_n(&my_ring->tail, __ATOMIC_ACQUIRE) >= LOGQ_SLOTS; spins++) {
+        if (!block) {
+            __atomic_fetch_add(&my_ring->dropped, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+        if (__atomic_load_n(&region->done, __ATOMIC_ACQUIRE)) return -1;
+        // a server that died will never drain the ring
+        if (spins % 1024 == 0 && kill(region->aggregator_pid, 0) == -1 && errno == ESRCH) return -1;
+        sched_yield();
+    }
+
+    LogqRecord *r = &my_ring->slots[head & (LOGQ_SLOTS - 1)];
+    r->wall_ns = now_ns();
+    r->sim_tick = shared_intersections
+        ? (uint32_t)__atomic_load_n(&shared_intersections[0].fakeSec, __ATOMIC_RELAXED) : 0;
+    r->len = len;
+    memcpy(r->text, line, len);
+    if (cut) r->text[len - 1] = '\n'; // the next record must start on its own line
+    __atomic_store_n(&my_ring->head, head + 1, __ATOMIC_SEQ_CST);
+
+    // pairs with the store of closing in logq_close_aggregator()
+    if (__atomic_load_n(&region->closing, __ATOMIC_SEQ_CST)) {
+        flush_own_ring(fallback_fd);
+    }
+    return 0;
+}
+
+static int by_sim_time(const void *a, const void *b) {
+    const LogqRecord *x = ((const LogqPick *)a)->rec;
+    const LogqRecord *y = ((const LogqPick *)b)->rec;
+    if (x->sim_tick != y->sim_tick) return x->sim_tick < y->sim_tick ? -1 : 1;
+    if (x->wall_ns != y->wall_ns) return x->wall_ns < y->wall_ns ? -1 : 1;
+    return 0;
+}
+
+static void write_all(int fd, struct iovec *iov, int n) {
+    ssize_t done = writev(fd, iov, n);
+    for (int i = 0; i < n && done >= 0; i++) {
+        if ((size_t)done >= iov[i].iov_len) {
+            done -= iov[i].iov_len;
+            continue;
+        }
+        const char *rest = (const char *)iov[i].iov_base + done;
+        if (write(fd, rest, iov[i].iov_len - done) < 0) break;
+        done = 0;
+    }
+}
+
+int logq_aggregate(int fd, int final) {
+    if (!region || !aggregator) return 0;
+    uint64_t cutoff = final ? UINT64_MAX : now_ns() - LOGQ_HOLD_NS;
+    uint64_t take[LOGQ_PRODUCERS];
+    int count = 0;
+
+    // each ring is already in order, so take a prefix of every ring
+    for (int i = 0; i < LOGQ_PRODUCERS; i++) {
+        LogqRing *ring = &region->rings[i];
+        uint64_t tail = ring->tail;
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+        uint64_t t = tail;
+        while (t < head) {
+            const LogqRecord *r = &ring->slots[t & (LOGQ_SLOTS - 1)];
+            if (r->wall_ns > cutoff) break;
+            picks[count++].rec = r;
+            t++;
+        }
+        take[i] = t;
+    }
+
+    if (count > 0) {
+        qsort(picks, count, sizeof(LogqPick), by_sim_time);
+        struct iovec iov[LOGQ_BATCH];
+        int n = 0;
+        for (int k = 0; k < count; k++) {
+            iov[n].iov_base = (void *)picks[k].rec->text;
+            iov[n].iov_len = picks[k].rec->len;
+            if (++n == LOGQ_BATCH) {
+                write_all(fd, iov, n);
+                n = 0;
+            }
+        }
+        if (n > 0) write_all(fd, iov, n);
+    }
+
+    // hand the slots back, then report drops
+    for (int i = 0; i < LOGQ_PRODUCERS; i++) {
+        LogqRing *ring = &region->rings[i];
+        if (take[i] != ring->tail) __atomic_store_n(&ring->tail, take[i], __ATOMIC_RELEASE);
+        long dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+        if (dropped > 0) {
+            char note[80];
+            int len = snprintf(note, sizeof(note), "LOGGER: dropped %ld records from pid %d\n",
+                               dropped, (int)ring->pid);
+            if (write(fd, note, len) < 0) break;
+        }
+    }
+    return count;
+}
+
+void logq_close_aggregator(int fd) {
+    if (!region || !aggregator) return;
+    __atomic_store_n(&region->closing, 1, __ATOMIC_SEQ_CST);
+    logq_aggregate(fd, 1);
+    __atomic_store_n(&region->done, 1, __ATOMIC_RELEASE);
+    munmap(region, sizeof(LogqRegion));
+    shm_unlink(LOGQ_SHM_NAME);
+    region = NULL;
+    aggregator = 0;
+}
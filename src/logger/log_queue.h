@@ -0,0 +1,60 @@
+// log_queue.h
+// Group: B
+// Date: 10-19-2026
+// Cross-process log aggregation. Each process that logs owns one single-producer ring in
+// the /rail_logq shared memory segment and publishes formatted lines into it instead of
+// calling write(). The server's logger thread is the only consumer: it merges the rings
+// by sim time and appends to simulation.log with writev(). Lines are held back for
+// LOGQ_HOLD_NS so a process that was descheduled between reading the clock and
+// publishing still lands in order.
+//
+// logger.c is the only user; everything else keeps calling log_event().
+#ifndef LOG_QUEUE_H
+#define LOG_QUEUE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define LOGQ_SHM_NAME    "/rail_logq"
+#define LOGQ_MAGIC       0x524c4751u    // "RLGQ"
+#define LOGQ_PRODUCERS   16             // server, train_sim and its trains
+#define LOGQ_SLOTS       256            // power of two
+#define LOGQ_RECORD_MAX  512            // same cut-off as the in-process ring, '\n' kept
+#define LOGQ_HOLD_NS     20000000L      // 20 ms reorder window
+
+typedef struct {
+    uint64_t wall_ns;
+    uint32_t sim_tick;
+    uint32_t len;
+    char     text[LOGQ_RECORD_MAX];
+} LogqRecord;
+
+typedef struct {
+    pid_t    pid;                       // 0 = free
+    uint64_t head;                      // written by the producer
+    uint64_t tail;                      // written by the aggregator
+    long     dropped;                   // lines lost to LOG_OVERFLOW_DROP
+    LogqRecord slots[LOGQ_SLOTS];
+} LogqRing;
+
+typedef struct {
+    uint32_t magic;
+    pid_t    aggregator_pid;
+    int      closing;                   // aggregator is doing its final pass
+    int      done;                      // aggregator is gone, write directly
+    LogqRing rings[LOGQ_PRODUCERS];
+} LogqRegion;
+
+int  logq_create(void);                 // server: new segment, this process aggregates
+int  logq_attach(void);                 // everyone else, -1 if no server is aggregating
+void logq_after_fork_child(void);       // the child claims its own ring on first use
+
+// 0 published, 1 dropped (ring full and !block), -1 not available: write it yourself
+int  logq_publish(const char *line, int len, int block, int fallback_fd);
+
+// aggregator: write everything older than the hold window (all of it if final).
+// Returns the number of lines written
+int  logq_aggregate(int fd, int final);
+void logq_close_aggregator(int fd);     // final pass, then producers write directly
+
+#endif // LOG_QUEUE_H
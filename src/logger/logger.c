@@ -15,13 +15,19 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h> // for strcasecmp()
 #include <unistd.h>
 #include <sys/stat.h>  // for stat()
 #include <sys/types.h> // for stat()
 #include <stdbool.h>   // for bool type
 #include <sys/mman.h>
+#include <sys/uio.h>   // for writev()
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include "../Basic_IPC_Workflow/fake_sec.h" // for getFakeTime()
 #include "../Shared_Memory_Setup/Memory_Segments.h" // for SharedIntersection Struct
+#include "log_queue.h"     // shared memory rings merged by the server
 
 /*
 In final iteration, the logger received the log_init and log_close functions\
@@ -32,7 +38,270 @@ and release of resources.
 static int log_fd = -1;
 size_t shm_size; // moved to global to reduce redundant init calls
 
+/*
+Asynchronous writer. log_event() only formats the line and copies it into a
+bounded lock-free ring (multi-producer, one consumer). A background thread
+drains the ring and writes whole batches with one writev() call, so the
+request path never makes a write() syscall. When the ring is full the
+producer either waits for room (LOG_OVERFLOW_BLOCK, default) or drops the
+line and counts it (LOG_OVERFLOW_DROP). log_close() and process exit drain
+everything that is still queued.
+
+Across processes: the server (log_init with truncate) creates the log_queue
+segment and its writer thread becomes the aggregator for every process.
+Trains and train_sim attach to it and publish into their own shared memory
+ring, so they never write simulation.log themselves and the file comes out
+in sim-time order. Without a server the old per-process path is used.
+*/
+#define LOG_RING_SLOTS 2048          // power of two
+#define LOG_RECORD_MAX 512           // longest line kept, longer ones are cut but keep their '\n'
+#define LOG_BATCH      64            // lines per writev()
+#define LOG_IDLE_NS    5000000L      // writer wakes at least every 5 ms
+
+typedef struct {
+    size_t seq;                      // == position when free, position + 1 when filled
+    int len;
+    char text[LOG_RECORD_MAX];
+} LogSlot;
+
+static LogSlot log_ring[LOG_RING_SLOTS];
+static size_t enqueue_pos;           // next position producers claim
+static size_t dequeue_pos;           // next position the writer drains
+static long dropped_records;
+static int overflow_policy = LOG_OVERFLOW_BLOCK;
+
+static pthread_t writer_thread;
+static pid_t writer_owner = 0;       // pid that started writer_thread (fork leaves children without one)
+static int writer_stop;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_wake;
+static int exit_hook_registered = 0;
+static int log_aggregator = 0;       // this process merges the shared memory rings
+static int log_shared = 0;           // publish into a shared memory ring
+
+static void ring_reset(void) {
+    for (size_t i = 0; i < LOG_RING_SLOTS; i++) {
+        __atomic_store_n(&log_ring[i].seq, i, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&enqueue_pos, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&dequeue_pos, 0, __ATOMIC_RELEASE);
+}
+
+// writes every line that is ready, LOG_BATCH at a time. Returns how many were written
+static int drain_ring(void) {
+    int total = 0;
+    for (;;) {
+        struct iovec iov[LOG_BATCH];
+        size_t pos = __atomic_load_n(&dequeue_pos, __ATOMIC_RELAXED);
+        int n = 0;
+        while (n < LOG_BATCH) {
+            LogSlot *slot = &log_ring[(pos + n) & (LOG_RING_SLOTS - 1)];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + n + 1) break;
+            iov[n].iov_base = slot->text;
+            iov[n].iov_len = slot->len;
+            n++;
+        }
+        if (n == 0) return total;
+
+        // writev may stop short, finish whatever it did not take
+        ssize_t done = writev(log_fd, iov, n);
+        for (int i = 0; i < n && done >= 0; i++) {
+            if ((size_t)done >= iov[i].iov_len) {
+                done -= iov[i].iov_len;
+                continue;
+            }
+            const char *rest = (const char *)iov[i].iov_base + done;
+            if (write(log_fd, rest, iov[i].iov_len - done) < 0) break;
+            done = 0;
+        }
+
+        // hand the slots back to producers
+        for (int i = 0; i < n; i++) {
+            LogSlot *slot = &log_ring[(pos + i) & (LOG_RING_SLOTS - 1)];
+            __atomic_store_n(&slot->seq, pos + i + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&dequeue_pos, pos + n, __ATOMIC_RELEASE);
+        total += n;
+    }
+}
+
+// the aggregator holds lines back for a short reorder window, so it only
+// goes round again straight away while it is still finding work
+static int drain_all(void) {
+    int n = drain_ring();
+    if (log_aggregator) n += logq_aggregate(log_fd, 0);
+    return n;
+}
+
+static void *log_writer(void *arg) {
+    (void)arg;
+    for (;;) {
+        if (drain_all() > 0) continue;
+        if (__atomic_load_n(&writer_stop, __ATOMIC_ACQUIRE)) {
+            drain_ring(); // anything queued between the last drain and the stop flag
+            break;
+        }
+        struct timespec until;
+        clock_gettime(CLOCK_MONOTONIC, &until);
+        until.tv_nsec += LOG_IDLE_NS;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&writer_lock);
+        pthread_cond_timedwait(&writer_wake, &writer_lock, &until);
+        pthread_mutex_unlock(&writer_lock);
+    }
+    return NULL;
+}
+
+static void wake_writer(void) {
+    pthread_mutex_lock(&writer_lock);
+    pthread_cond_signal(&writer_wake);
+    pthread_mutex_unlock(&writer_lock);
+}
+
+static void start_writer(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&writer_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    writer_stop = 0;
+    if (pthread_create(&writer_thread, NULL, log_writer, NULL) == 0) {
+        writer_owner = getpid();
+    } else {
+        writer_owner = 0; // stays synchronous, log_event drains inline
+    }
+}
+
+static void stop_writer(void) {
+    if (writer_owner == getpid()) {
+        __atomic_store_n(&writer_stop, 1, __ATOMIC_RELEASE);
+        wake_writer();
+        pthread_join(writer_thread, NULL);
+        writer_owner = 0;
+    } else if (log_fd >= 0) {
+        drain_ring();
+    }
+}
+
+// trains are forked after log_init: the child inherits the parent's queued lines
+// (the parent writes those) but not its writer thread, so start clean
+static void log_after_fork_child(void) {
+    pthread_mutex_init(&writer_lock, NULL);
+    ring_reset();
+    writer_owner = 0;
+    log_aggregator = 0;
+    logq_after_fork_child();
+}
+
+// forked trains call exit() without log_close(), make sure their lines still land
+static void log_flush_at_exit(void) {
+    stop_writer();
+    if (log_aggregator) {
+        logq_close_aggregator(log_fd);
+        log_aggregator = 0;
+        log_shared = 0;
+    }
+    if (dropped_records > 0 && log_fd >= 0) {
+        char note[64];
+        int len = snprintf(note, sizeof(note), "LOGGER: dropped %ld records\n", dropped_records);
+        write(log_fd, note, len);
+        dropped_records = 0;
+    }
+}
+
+int log_level = LOG_LEVEL_DEBUG;
+
+void log_set_level(int level) {
+    if (level < LOG_LEVEL_TRACE) level = LOG_LEVEL_TRACE;
+    if (level > LOG_LEVEL_OFF) level = LOG_LEVEL_OFF;
+    log_level = level;
+}
+
+int log_parse_level(const char *text) {
+    static const char *names[] = { "trace", "debug", "info", "warn", "error", "off" };
+    if (!text || !*text) return -1;
+    if (text[0] >= '0' && text[0] <= '9') {
+        int level = atoi(text);
+        return (level <= LOG_LEVEL_OFF) ? level : -1;
+    }
+    for (int i = 0; i <= LOG_LEVEL_OFF; i++) {
+        if (strcasecmp(text, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+void log_set_overflow(int policy) {
+    overflow_policy = policy;
+}
+
+// copies one formatted line into the ring. Lock-free unless the ring is full
+static void log_enqueue(const char *line, int len) {
+    if (log_shared) {
+        int rc = logq_publish(line, len, overflow_policy == LOG_OVERFLOW_BLOCK, log_fd);
+        if (rc == 0 || rc == 1) return;
+        log_shared = 0; // the server is gone, fall back to writing ourselves
+    }
+    if (writer_owner != getpid()) {
+        start_writer();
+        if (writer_owner != getpid()) {
+            write(log_fd, line, len); // no thread, stay synchronous
+            return;
+        }
+    }
+    int cut = len > LOG_RECORD_MAX;
+    if (cut) len = LOG_RECORD_MAX;
+
+    size_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+    LogSlot *slot;
+    for (;;) {
+        slot = &log_ring[pos & (LOG_RING_SLOTS - 1)];
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // full
+            if (overflow_policy == LOG_OVERFLOW_DROP) {
+                __atomic_fetch_add(&dropped_records, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            wake_writer();
+            sched_yield();
+            pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        } else {
+            pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(slot->text, line, len);
+    if (cut) slot->text[len - 1] = '\n'; // the next record must start on its own line
+    slot->len = len;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // only bother the writer when the ring is filling up, otherwise its 5 ms tick picks it up
+    if (pos - __atomic_load_n(&dequeue_pos, __ATOMIC_ACQUIRE) == LOG_RING_SLOTS / 4) {
+        wake_writer();
+    }
+}
+
 void log_init(const char *filename, int truncate) {
+    const char *env_level = getenv("RAIL_LOG_LEVEL");
+    if (env_level) {
+        int level = log_parse_level(env_level);
+        if (level < 0) {
+            fprintf(stderr, "Unknown RAIL_LOG_LEVEL \"%s\", using debug\n", env_level);
+        } else {
+            log_set_level(level);
+        }
+    }
+
     //clean old memory on server. Fixes issue from previous iterations
     if (truncate) {
         shm_unlink("/intersection_shm");
@@ -40,7 +309,7 @@ void log_init(const char *filename, int truncate) {
 
     //check for existing shared memory, create new if not found
     if (!shared_intersections) {
-        size_t shm_size = sizeof(SharedIntersection) * NUM_INTERSECTIONS;
+        size_t shm_size = SHM_SEGMENT_SIZE;
         shared_intersections = init_shared_memory("/intersection_shm", &shm_size);
         if (!shared_intersections) {
             fprintf(stderr, "Failed to initialize shared memory.\n");
@@ -48,12 +317,12 @@ void log_init(const char *filename, int truncate) {
         }
         
         //reset time values on parent process
-        pthread_mutex_lock(&shared_intersections[0].mutex);
+        shm_lock(shared_intersections, 0, LOCK_SITE_CLOCK);
         shared_intersections[0].fakeSec = 0;
         shared_intersections[0].fakeMin = 0;
         shared_intersections[0].fakeMinSec = 0;
         shared_intersections[0].fakeHour = 0;
-        pthread_mutex_unlock(&shared_intersections[0].mutex);
+        shm_unlock(shared_intersections, 0, LOCK_SITE_CLOCK);
     }
     
     //use flags limit actions on file to create, write, append
@@ -65,7 +334,22 @@ void log_init(const char *filename, int truncate) {
     log_fd = open(filename, flags, 0666);
     if (log_fd < 0) {
         perror("open simulation.log");
+        return;
+    }
+
+    ring_reset();
+    if (truncate) {
+        log_aggregator = (logq_create() == 0);
+        log_shared = log_aggregator;
+    } else {
+        log_shared = (logq_attach() == 0);
+    }
+    if (!exit_hook_registered) {
+        pthread_atfork(NULL, NULL, log_after_fork_child);
+        atexit(log_flush_at_exit);
+        exit_hook_registered = 1;
     }
+    start_writer();
 }
 
 void log_event(const char *component, const char *fmt, ...) {
@@ -91,11 +375,12 @@ void log_event(const char *component, const char *fmt, ...) {
         buffer[offset] = '\0';
     }
 
-    /* Write the formatted string to the log file */
-    write(log_fd, buffer, strlen(buffer));
+    /* Queue the formatted string for the writer thread */
+    log_enqueue(buffer, strlen(buffer));
 }
 
 void log_close(void) {
+    log_flush_at_exit(); // drains the ring and stops the writer thread
     if (log_fd >= 0) {
         close(log_fd);
         log_fd = -1;
@@ -122,7 +407,7 @@ void log_close(void) {
         }
 
         //unmap shared memory
-        munmap(shared_intersections, sizeof(SharedIntersection) * NUM_INTERSECTIONS);
+        munmap(shared_intersections, SHM_SEGMENT_SIZE);
         shm_unlink("/intersection_shm");
         shared_intersections = NULL;
     }
@@ -18,6 +18,14 @@ extern size_t shm_size; // moved to global to reduce redundant init calls
 void log_init(const char *filename, int truncate);
 void log_close(void);
 
+/* log_event() hands lines to a background writer thread through a bounded ring.
+ * What happens when the ring is full: LOG_OVERFLOW_BLOCK (default) waits for room,
+ * LOG_OVERFLOW_DROP drops the line and reports the count when the log is closed.
+ */
+#define LOG_OVERFLOW_BLOCK 0
+#define LOG_OVERFLOW_DROP  1
+void log_set_overflow(int policy);
+
 /* Write a log event.
  * The 'component' is a string that identifies the source (e.g., "SERVER", "TRAIN1").
  * The fmt and additional arguments are similar to printf.
@@ -26,22 +34,59 @@ void log_event(const char *component, const char *fmt, ...);
 
 
 
+/* Log levels. LOG_COMPILE_LEVEL removes everything below it at build time
+ * (make LOG_LEVEL=WARN); log_level filters at run time and starts from the
+ * RAIL_LOG_LEVEL environment variable (name or number, default DEBUG).
+ * The macros test the level before getFakeTime() or any argument is evaluated.
+ */
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   5
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+
+extern int log_level;
+void log_set_level(int level);
+int log_parse_level(const char *text); // "warn" or "3" -> LOG_LEVEL_WARN, -1 if unknown
+
+#define LOG_ENABLED(lvl) ((lvl) >= LOG_COMPILE_LEVEL && (lvl) >= log_level)
+
 /* Convenience macros for common components.
 Updated 4.20.2025
 Updated macros to include calls to get timeString
 Updated by jarett on 4.19 to include time string
+LOG_SERVER/LOG_TRAIN log at INFO, the _AT forms take an explicit level.
 */
-#define LOG_SERVER(fmt, ...) do { \
-    char comp[64];\
-    snprintf(comp, sizeof(comp), "%s SERVER", getFakeTime());\
-    log_event(comp, fmt, ##__VA_ARGS__);\
+#define LOG_SERVER_AT(lvl, fmt, ...) do { \
+    if (LOG_ENABLED(lvl)) { \
+        char comp[64];\
+        snprintf(comp, sizeof(comp), "%s SERVER", getFakeTime());\
+        log_event(comp, fmt, ##__VA_ARGS__);\
+    } \
 } while(0)
 
 //comp size increased to 32 to accommodate addition of time string
-#define LOG_TRAIN(id, fmt, ...) do { \
-    char comp[64]; \
-    snprintf(comp, sizeof(comp), "%s TRAIN%d", getFakeTime(), (id)); \
-    log_event(comp, fmt, ##__VA_ARGS__); \
+#define LOG_TRAIN_AT(lvl, id, fmt, ...) do { \
+    if (LOG_ENABLED(lvl)) { \
+        char comp[64]; \
+        snprintf(comp, sizeof(comp), "%s TRAIN%d", getFakeTime(), (id)); \
+        log_event(comp, fmt, ##__VA_ARGS__); \
+    } \
+} while(0)
+
+#define LOG_SERVER(fmt, ...) LOG_SERVER_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_TRAIN(id, fmt, ...) LOG_TRAIN_AT(LOG_LEVEL_INFO, id, fmt, ##__VA_ARGS__)
+
+// stdout echo with the fake time in front, same gate as the log file
+#define LOG_CONSOLE(lvl, fmt, ...) do { \
+    if (LOG_ENABLED(lvl)) { \
+        printf("%s " fmt, getFakeTime(), ##__VA_ARGS__); \
+    } \
 } while(0)
 
 #endif /* LOGGER_H */
\ No newline at end of file
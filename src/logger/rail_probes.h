@@ -0,0 +1,43 @@
+// rail_probes.h
+// Group: B
+// Date: 10-19-2026
+// USDT (sys/sdt.h) static tracepoints on the request path, provider "railway".
+// A probe is a single nop plus a note in the ELF file, so it costs nothing until
+// perf, bpftrace or systemtap attaches to it. They are compiled in whenever
+// <sys/sdt.h> exists (systemtap-sdt-dev / systemtap-sdt-devel); without it, or with
+// make USDT=0, every RAIL_PROBE is empty and its arguments are not evaluated.
+//
+//   bpftrace -l 'usdt:./iLikeTrains:railway:*'
+//   bpftrace -e 'usdt:./iLikeTrains:railway:admission { @[str(arg2)] = count(); }'
+//
+// Probes and arguments:
+//   iLikeTrains  request_received  train_id, action, intersection
+//                lookup_done       train_id, intersection index (-1 unknown)
+//                admission         train_id, index, decision ("GRANT", "WAIT", "FAIL")
+//                waiter_dequeued   train_id, index (-1 for a queued ACQ_SET)
+//                reply_sent        train_id, action, intersection
+//                lock_acquire      intersection, capacity, result (0 taken, 1 timed out)
+//                lock_release      intersection, capacity
+//   train_sim    acquire_sent      train_id, intersection
+//                grant_received    train_id, intersection
+#ifndef RAIL_PROBES_H
+#define RAIL_PROBES_H
+
+#ifndef RAIL_USDT
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define RAIL_USDT 1
+#endif
+#endif
+#endif
+
+#if defined(RAIL_USDT) && RAIL_USDT
+#include <sys/sdt.h>
+#define RAIL_PROBE2(name, a, b)    DTRACE_PROBE2(railway, name, a, b)
+#define RAIL_PROBE3(name, a, b, c) DTRACE_PROBE3(railway, name, a, b, c)
+#else
+#define RAIL_PROBE2(name, a, b)    do { } while (0)
+#define RAIL_PROBE3(name, a, b, c) do { } while (0)
+#endif
+
+#endif // RAIL_PROBES_H
@@ -0,0 +1,197 @@
+// trace.c
+// Group: B
+// Date: 10-19-2026
+// Per-process binary trace files. The file is a header page followed by TraceRecords
+// and is mapped MAP_SHARED, so records already written survive a crash; the header
+// count says how many are valid. The file grows TRACE_CHUNK records at a time and
+// trace_close() trims it to what was written.
+#define _GNU_SOURCE
+#include "trace.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TRACE_DATA_OFFSET 4096   // records start on the second page
+
+TraceWriter trace_writer = { NULL, NULL, 0, 0, -1 };
+
+static const char *op_names[TRACE_OP_COUNT] = { "NONE", "ACQUIRE", "RELEASE", "ACQ_SET", "STOP" };
+static const char *result_names[TRACE_RES_COUNT] = { "", "GRANT", "WAIT", "OK", "FAIL", "TIMEOUT" };
+static int atfork_registered = 0;
+
+static size_t map_size_for(uint64_t records) {
+    return TRACE_DATA_OFFSET + records * sizeof(TraceRecord);
+}
+
+// the child gets a copy of the parent's mapping; it must not append to the parent's file
+static void trace_after_fork_child(void) {
+    if (trace_writer.header) {
+        munmap(trace_writer.header, trace_writer.map_size);
+        close(trace_writer.fd);
+    }
+    trace_writer.header = NULL;
+    trace_writer.records = NULL;
+    trace_writer.capacity = 0;
+    trace_writer.map_size = 0;
+    trace_writer.fd = -1;
+}
+
+int trace_open(const char *dir, const char *role) {
+    if (trace_writer.header) trace_close();
+    if (!atfork_registered) {
+        pthread_atfork(NULL, NULL, trace_after_fork_child);
+        atexit(trace_close); // trims the file however the process exits normally
+        atfork_registered = 1;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/trace_%s_%d.bin", dir, role, (int)getpid());
+    int fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror("trace open");
+        return -1;
+    }
+    size_t size = map_size_for(TRACE_CHUNK);
+    if (ftruncate(fd, size) == -1) {
+        perror("trace ftruncate");
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("trace mmap");
+        close(fd);
+        return -1;
+    }
+
+    TraceHeader *h = map;
+    memcpy(h->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    h->version = TRACE_VERSION;
+    h->record_size = sizeof(TraceRecord);
+    h->pid = getpid();
+    h->name_count = 0;
+    h->count = 0;
+    snprintf(h->role, sizeof(h->role), "%s", role);
+
+    trace_writer.header = h;
+    trace_writer.records = (TraceRecord *)((char *)map + TRACE_DATA_OFFSET);
+    trace_writer.capacity = TRACE_CHUNK;
+    trace_writer.map_size = size;
+    trace_writer.fd = fd;
+    return 0;
+}
+
+// called from trace_record() when the mapping is full
+int trace_grow(void) {
+    TraceWriter *w = &trace_writer;
+    uint64_t capacity = w->capacity + TRACE_CHUNK;
+    size_t size = map_size_for(capacity);
+    if (ftruncate(w->fd, size) == -1) {
+        perror("trace ftruncate");
+        return -1;
+    }
+    void *map = mremap(w->header, w->map_size, size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+        perror("trace mremap");
+        return -1;
+    }
+    w->header = map;
+    w->records = (TraceRecord *)((char *)map + TRACE_DATA_OFFSET);
+    w->capacity = capacity;
+    w->map_size = size;
+    return 0;
+}
+
+void trace_close(void) {
+    TraceWriter *w = &trace_writer;
+    if (!w->header) return;
+    uint64_t count = w->header->count;
+    munmap(w->header, w->map_size);
+    if (ftruncate(w->fd, map_size_for(count)) == -1) {
+        perror("trace ftruncate");
+    }
+    close(w->fd);
+    w->header = NULL;
+    w->records = NULL;
+    w->capacity = 0;
+    w->map_size = 0;
+    w->fd = -1;
+}
+
+int trace_intern(const char *name) {
+    TraceHeader *h = trace_writer.header;
+    if (!h) return TRACE_NO_NAME;
+    for (uint32_t i = 0; i < h->name_count; i++) {
+        if (strncmp(h->names[i], name, TRACE_NAME_LEN - 1) == 0) return i;
+    }
+    if (h->name_count >= TRACE_MAX_NAMES) return TRACE_NO_NAME;
+    snprintf(h->names[h->name_count], TRACE_NAME_LEN, "%s", name);
+    return h->name_count++;
+}
+
+int trace_op_code(const char *action) {
+    for (int i = 1; i < TRACE_OP_COUNT; i++) {
+        if (strcmp(action, op_names[i]) == 0) return i;
+    }
+    return TRACE_OP_NONE;
+}
+
+int trace_result_code(const char *action) {
+    for (int i = 1; i < TRACE_RES_COUNT; i++) {
+        if (strcmp(action, result_names[i]) == 0) return i;
+    }
+    return TRACE_RES_NONE;
+}
+
+const char *trace_op_name(int op) {
+    return (op >= 0 && op < TRACE_OP_COUNT) ? op_names[op] : "?";
+}
+
+const char *trace_result_name(int result) {
+    return (result >= 0 && result < TRACE_RES_COUNT) ? result_names[result] : "?";
+}
+
+int trace_file_open(const char *path, TraceFile *out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < TRACE_DATA_OFFSET) {
+        fprintf(stderr, "%s: too short for a trace\n", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("trace mmap");
+        return -1;
+    }
+
+    const TraceHeader *h = map;
+    if (memcmp(h->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        h->version != TRACE_VERSION || h->record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s: not a version %d trace\n", path, TRACE_VERSION);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    // a crashed writer leaves the file longer than count, a truncated copy shorter
+    uint64_t fits = (st.st_size - TRACE_DATA_OFFSET) / sizeof(TraceRecord);
+    out->header = h;
+    out->records = (const TraceRecord *)((const char *)map + TRACE_DATA_OFFSET);
+    out->count = h->count < fits ? h->count : fits;
+    out->map_size = st.st_size;
+    return 0;
+}
+
+void trace_file_close(TraceFile *file) {
+    if (file->header) munmap((void *)file->header, file->map_size);
+    file->header = NULL;
+}
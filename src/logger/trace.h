@@ -0,0 +1,134 @@
+// trace.h
+// Group: B
+// Date: 10-19-2026
+// Binary event trace. Each process appends fixed 24-byte records to its own
+// memory-mapped file, so recording an event is a clock read and a few stores.
+// Intersection names are interned once into the file header and records carry
+// the small id. tools/raildecode turns a trace back into CSV rows or text.
+//
+// Tracing is off unless trace_open() is called; the server and each train call
+// it when RAIL_TRACE names a directory. trace_event() also feeds the always-on
+// flight recorder (flight_recorder.h).
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "flight_recorder.h"
+
+#define TRACE_MAGIC      "RAILTRC"
+#define TRACE_VERSION    2       // 2: train_id widened to 32 bits
+#define TRACE_MAX_NAMES  32
+#define TRACE_NAME_LEN   32
+#define TRACE_NO_NAME    0xFF
+#define TRACE_CHUNK      65536   // records added each time the file grows
+
+// what the event was about
+enum {
+    TRACE_OP_NONE = 0,
+    TRACE_OP_ACQUIRE,
+    TRACE_OP_RELEASE,
+    TRACE_OP_ACQ_SET,
+    TRACE_OP_STOP,
+    TRACE_OP_COUNT
+};
+
+// how it came out. NONE marks the request itself
+enum {
+    TRACE_RES_NONE = 0,
+    TRACE_RES_GRANT,
+    TRACE_RES_WAIT,
+    TRACE_RES_OK,
+    TRACE_RES_FAIL,
+    TRACE_RES_TIMEOUT,
+    TRACE_RES_COUNT
+};
+
+typedef struct {
+    uint64_t wall_ns;        // CLOCK_REALTIME
+    uint32_t sim_tick;       // fake seconds since the server started
+    uint32_t train_id;       // 0 = server/system, else the N of TrainN (up to 999999)
+    uint8_t  intersection;   // index into TraceHeader.names, TRACE_NO_NAME if none
+    uint8_t  opcode;
+    uint8_t  result;
+    uint8_t  pad[5];
+} TraceRecord;
+
+_Static_assert(sizeof(TraceRecord) == 24, "TraceRecord is part of the file format");
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    int32_t  pid;
+    uint32_t name_count;
+    uint64_t count;          // records written so far, valid even if the process died
+    char     role[TRACE_NAME_LEN];
+    char     names[TRACE_MAX_NAMES][TRACE_NAME_LEN];
+} TraceHeader;
+
+// writer state of this process. A forked child starts with tracing off and
+// opens its own file
+typedef struct {
+    TraceHeader *header;
+    TraceRecord *records;
+    uint64_t capacity;
+    size_t map_size;
+    int fd;
+} TraceWriter;
+
+extern TraceWriter trace_writer;
+
+// dir/trace_<role>_<pid>.bin. Returns 0, or -1 with tracing left off
+int  trace_open(const char *dir, const char *role);
+void trace_close(void);
+int  trace_grow(void);
+int  trace_intern(const char *name);              // id for name, TRACE_NO_NAME if the table is full
+int  trace_op_code(const char *action);           // "ACQUIRE" -> TRACE_OP_ACQUIRE
+int  trace_result_code(const char *action);       // "GRANT" -> TRACE_RES_GRANT
+const char *trace_op_name(int op);
+const char *trace_result_name(int result);
+
+static inline void trace_record(int train_id, int intersection, int op, int result) {
+    TraceWriter *w = &trace_writer;
+    if (!w->header) return;
+    uint64_t n = w->header->count;
+    if (n >= w->capacity && trace_grow() != 0) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    TraceRecord *r = &w->records[n];
+    r->wall_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    r->sim_tick = shared_intersections
+        ? (uint32_t)__atomic_load_n(&shared_intersections[0].fakeSec, __ATOMIC_RELAXED) : 0;
+    r->train_id = (uint32_t)train_id;
+    r->intersection = (uint8_t)intersection;
+    r->opcode = (uint8_t)op;
+    r->result = (uint8_t)result;
+    // a reader of a crashed run only trusts records below count
+    __atomic_store_n(&w->header->count, n + 1, __ATOMIC_RELEASE);
+}
+
+// the hook at every request and reply: always feeds the flight recorder ring,
+// and the trace file when one is open (looking the name up first)
+static inline void trace_event(int train_id, const char *intersection, int op, int result) {
+    flight_record(train_id, intersection, op, result);
+    if (!trace_writer.header) return;
+    trace_record(train_id, intersection ? trace_intern(intersection) : TRACE_NO_NAME, op, result);
+}
+
+// Reading, for raildecode. Maps a whole trace file read-only
+typedef struct {
+    const TraceHeader *header;
+    const TraceRecord *records;
+    uint64_t count;
+    size_t map_size;
+} TraceFile;
+
+int  trace_file_open(const char *path, TraceFile *out);
+void trace_file_close(TraceFile *file);
+
+#endif // TRACE_H
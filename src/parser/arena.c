@@ -0,0 +1,47 @@
+// arena.c
+// Group: B
+// Date: 10-19-2026
+// Scenario arena, see arena.h.
+#include "arena.h"
+#include <stdio.h>
+#include <sys/mman.h>
+
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+    ArenaBlock *next;       // older block
+    size_t size, used;      // size includes this header
+};
+
+void arena_init(Arena *a) {
+    a->head = NULL;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaBlock *b = a->head;
+    if (!b || b->size - b->used < size) {
+        size_t header = (sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        size_t block = header + size > ARENA_BLOCK_MIN ? header + size : ARENA_BLOCK_MIN;
+        b = mmap(NULL, block, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (b == MAP_FAILED) {
+            perror("arena mmap");
+            return NULL;
+        }
+        b->next = a->head;
+        b->size = block;
+        b->used = header;
+        a->head = b;
+    }
+    void *p = (char *)b + b->used;
+    b->used += size;
+    return p;
+}
+
+void arena_free(Arena *a) {
+    while (a->head) {
+        ArenaBlock *next = a->head->next;
+        munmap(a->head, a->head->size);
+        a->head = next;
+    }
+}
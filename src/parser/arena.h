@@ -0,0 +1,26 @@
+// arena.h
+// Group: B
+// Date: 10-19-2026
+// Bump allocator for parsed scenarios. Memory comes from anonymous mappings and is
+// only given back all at once, so a parse can reserve a generous upper bound in one
+// call: pages it never touches are never backed by RAM.
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_MIN (1 << 20)
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;       // newest block, the one being filled
+} Arena;
+
+void  arena_init(Arena *a);
+// size bytes aligned for any type, zero filled. NULL when out of memory
+void *arena_alloc(Arena *a, size_t size);
+// unmaps every block
+void  arena_free(Arena *a);
+
+#endif // ARENA_H
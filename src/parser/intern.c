@@ -0,0 +1,162 @@
+// intern.c
+// Group: B
+// Date: 10-19-2026
+// Name table for the scenario parser, see intern.h.
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAMES_INITIAL 64        // ids, the index starts at twice this many slots
+
+// FNV-1a. Names that differ only in their last characters (Train1, Train2, ...) land
+// near each other in the index, which keeps interning a million of them in cache
+static uint32_t names_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int names_init(NameTable *t) {
+    memset(t, 0, sizeof(*t));
+    t->cap = NAMES_INITIAL;
+    t->text_cap = NAMES_INITIAL * 16;
+    t->text = malloc(t->text_cap);
+    t->offset = malloc(t->cap * sizeof(uint32_t));
+    t->length = malloc(t->cap * sizeof(uint32_t));
+    t->hash = malloc(t->cap * sizeof(uint32_t));
+    t->slots = calloc(2 * NAMES_INITIAL, sizeof(int));
+    t->slot_mask = 2 * NAMES_INITIAL - 1;
+    if (!t->text || !t->offset || !t->length || !t->hash || !t->slots) {
+        perror("names_init");
+        names_free(t);
+        return -1;
+    }
+    return 0;
+}
+
+void names_free(NameTable *t) {
+    free(t->text);
+    free(t->offset);
+    free(t->length);
+    free(t->hash);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
+
+// slot holding the name, or the empty slot where it would go
+static int names_slot(const NameTable *t, const char *s, size_t len, uint32_t h) {
+    int i = h & t->slot_mask;
+    while (t->slots[i]) {
+        int id = t->slots[i] - 1;
+        if (t->hash[id] == h && t->length[id] == len && memcmp(t->text + t->offset[id], s, len) == 0) {
+            return i;
+        }
+        i = (i + 1) & t->slot_mask;
+    }
+    return i;
+}
+
+int names_find(const NameTable *t, const char *s, size_t len) {
+    if (!t->slots) return -1;
+    int i = names_slot(t, s, len, names_hash(s, len));
+    return t->slots[i] - 1;
+}
+
+// rebuilds the index with slot_count slots, a power of two
+static int names_rebuild_index(NameTable *t, int slot_count) {
+    int *slots = calloc(slot_count, sizeof(int));
+    if (!slots) return -1;
+    for (int id = 0; id < t->count; id++) {
+        int i = t->hash[id] & (slot_count - 1);
+        while (slots[i]) i = (i + 1) & (slot_count - 1);
+        slots[i] = id + 1;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slot_mask = slot_count - 1;
+    return 0;
+}
+
+// keeps the index at most half full
+static int names_grow_index(NameTable *t) {
+    return names_rebuild_index(t, 2 * (t->slot_mask + 1));
+}
+
+static int names_grow(NameTable *t, size_t len) {
+    if (t->count == t->cap) {
+        int cap = 2 * t->cap;
+        uint32_t *offset = realloc(t->offset, cap * sizeof(uint32_t));
+        if (offset) t->offset = offset;
+        uint32_t *length = realloc(t->length, cap * sizeof(uint32_t));
+        if (length) t->length = length;
+        uint32_t *hash = realloc(t->hash, cap * sizeof(uint32_t));
+        if (hash) t->hash = hash;
+        if (!offset || !length || !hash) return -1;
+        t->cap = cap;
+    }
+    if (t->text_len + len + 1 > t->text_cap) {
+        size_t cap = t->text_cap;
+        while (t->text_len + len + 1 > cap) cap *= 2;
+        if (cap > UINT32_MAX) return -1;
+        char *text = realloc(t->text, cap);
+        if (!text) return -1;
+        t->text = text;
+        t->text_cap = cap;
+    }
+    if (2 * (t->count + 1) > t->slot_mask + 1 && names_grow_index(t) == -1) return -1;
+    return 0;
+}
+
+int names_reserve(NameTable *t, int count, size_t text_len) {
+    if (count > t->cap) {
+        uint32_t *offset = realloc(t->offset, count * sizeof(uint32_t));
+        if (offset) t->offset = offset;
+        uint32_t *length = realloc(t->length, count * sizeof(uint32_t));
+        if (length) t->length = length;
+        uint32_t *hash = realloc(t->hash, count * sizeof(uint32_t));
+        if (hash) t->hash = hash;
+        if (!offset || !length || !hash) return -1;
+        t->cap = count;
+    }
+    if (text_len > t->text_cap) {
+        if (text_len > UINT32_MAX) return -1;
+        char *text = realloc(t->text, text_len);
+        if (!text) return -1;
+        t->text = text;
+        t->text_cap = text_len;
+    }
+    int slot_count = t->slot_mask + 1;
+    while (slot_count < 2 * count) slot_count *= 2;
+    if (slot_count != t->slot_mask + 1 && names_rebuild_index(t, slot_count) == -1) return -1;
+    return 0;
+}
+
+int names_intern(NameTable *t, const char *s, size_t len) {
+    return names_intern_hashed(t, s, len, names_hash(s, len));
+}
+
+int names_intern_hashed(NameTable *t, const char *s, size_t len, uint32_t h) {
+    int i = names_slot(t, s, len, h);
+    if (t->slots[i]) return t->slots[i] - 1;
+
+    int slot_count = t->slot_mask + 1;
+    if (names_grow(t, len) == -1) {
+        fprintf(stderr, "names_intern: out of memory after %d names\n", t->count);
+        return -1;
+    }
+    if (t->slot_mask + 1 != slot_count) i = names_slot(t, s, len, h); // the index was rebuilt
+
+    int id = t->count++;
+    t->offset[id] = (uint32_t)t->text_len;
+    t->length[id] = (uint32_t)len;
+    memcpy(t->text + t->text_len, s, len);
+    t->text[t->text_len + len] = '\0';
+    t->text_len += len + 1;
+    t->hash[id] = h;
+    t->slots[i] = id + 1;
+    return id;
+}
@@ -0,0 +1,48 @@
+// intern.h
+// Group: B
+// Date: 10-19-2026
+// String interning for the scenario parser. Every distinct name is stored once, NUL
+// terminated, in one growing text buffer and gets a small integer id in first-seen
+// order, so routes can be kept as arrays of ids instead of copies of the names.
+// Lookups take a pointer and a length, which lets the parser intern fields straight
+// out of the mapped file without terminating or copying them first.
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    char *text;             // every name back to back, each followed by '\0'
+    size_t text_len, text_cap;
+    uint32_t *offset;       // id -> start of the name in text
+    uint32_t *length;       // id -> length without the '\0'
+    uint32_t *hash;         // id -> hash, checked before the name and reused when the index grows
+    int count, cap;
+    int *slots;             // open addressing index: id + 1, 0 = empty
+    int slot_mask;          // slot count - 1, the slot count is a power of two
+} NameTable;
+
+int  names_init(NameTable *t);
+void names_free(NameTable *t);
+// makes room for count names of text_len bytes in all, their '\0's included, so
+// interning that many grows nothing. -1 when out of memory
+int  names_reserve(NameTable *t, int count, size_t text_len);
+
+// id of the name, adding it if it is new. -1 when out of memory
+int names_intern(NameTable *t, const char *s, size_t len);
+// the same with the hash already known, e.g. copied from another table's hash[]
+int names_intern_hashed(NameTable *t, const char *s, size_t len, uint32_t hash);
+// id of the name, -1 when it was never interned
+int names_find(const NameTable *t, const char *s, size_t len);
+
+// the interned name; the pointer is only good until the next names_intern()
+static inline const char *names_get(const NameTable *t, int id) {
+    return t->text + t->offset[id];
+}
+
+static inline size_t names_len(const NameTable *t, int id) {
+    return t->length[id];
+}
+
+#endif // INTERN_H
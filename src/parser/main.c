@@ -4,20 +4,17 @@
 #include "parser/parser.h"
 
 int main(){
-    // create array of train structs and count
-    TrainEntry trains[LINE_MAX];
-    int trainCount = getTrains(trains);
-
-    // create array of intersections tructs and count
-    IntersectionEntry intersections[LINE_MAX];
-    int intersectionCount = getIntersections(intersections);
+    // parse intersections first so they get the low ids, then trains
+    Scenario sc;
+    if (scenario_init(&sc) == -1 || getIntersections(&sc) < 0 || getTrains(&sc) < 0) return 1;
     
     // PRINT CHECK. 
     // Print individual train entries
     printf("Train Entries:\n"); 
-    printTrainEntries(trains, trainCount);
+    printTrainEntries(&sc, sc.train_count);
 
     // Print all train entries
     printf("Intersection Entries:\n");
-    printIntersectionEntries(intersections, intersectionCount);
+    printIntersectionEntries(&sc);
+    scenario_free(&sc);
 }
\ No newline at end of file
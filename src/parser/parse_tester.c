@@ -11,65 +11,64 @@ Date: 4.4.2025
 #include "parser.h"
 
 // Test for correct parsing of trains
-void test_getTrains() {
-    TrainEntry trains[LINE_MAX];
-    int count = getTrains(trains);
-    assert(count == 4);  // You expect 4 trains in the file
+void test_getTrains(const Scenario *sc) {
+    assert(sc->train_count == 4);  // You expect 4 trains in the file
 
     // Check Train1
-    assert(strcmp(trains[0].id, "Train1") == 0);
-    assert(trains[0].routeLength == 3);
-    assert(strcmp(trains[0].route[0], "IntersectionA") == 0);
-    assert(strcmp(trains[0].route[1], "IntersectionB") == 0);
-    assert(strcmp(trains[0].route[2], "IntersectionC") == 0);
+    TrainEntry train1 = scenario_train(sc, 0);
+    assert(strcmp(train1.id, "Train1") == 0);
+    assert(train1.routeLength == 3);
+    assert(strcmp(scenario_name(sc, train1.route[0]), "IntersectionA") == 0);
+    assert(strcmp(scenario_name(sc, train1.route[1]), "IntersectionB") == 0);
+    assert(strcmp(scenario_name(sc, train1.route[2]), "IntersectionC") == 0);
 
     // Check Train4
-    assert(strcmp(trains[3].id, "Train4") == 0);
-    assert(strcmp(trains[3].route[2], "IntersectionD") == 0);
+    TrainEntry train4 = scenario_train(sc, 3);
+    assert(strcmp(train4.id, "Train4") == 0);
+    assert(strcmp(scenario_name(sc, train4.route[2]), "IntersectionD") == 0);
 
     printf("test_getTrains passed\n");
 }
 
 // Test for correct parsing of intersections
-void test_getIntersections() {
-    IntersectionEntry intersections[LINE_MAX];
-    int count = getIntersections(intersections);
-    assert(count == 5);  // You expect 5 intersections
+void test_getIntersections(const Scenario *sc) {
+    assert(sc->intersection_count == 5);  // You expect 5 intersections
 
-    assert(strcmp(intersections[0].id, "IntersectionA") == 0);
-    assert(intersections[0].capacity == 1);
-    assert(intersections[0].available == 1);
+    assert(strcmp(scenario_name(sc, 0), "IntersectionA") == 0);
+    assert(sc->intersections[0].capacity == 1);
 
-    assert(strcmp(intersections[3].id, "IntersectionD") == 0);
-    assert(intersections[3].capacity == 3);
+    assert(strcmp(scenario_name(sc, 3), "IntersectionD") == 0);
+    assert(sc->intersections[3].capacity == 3);
+    assert(find_intersection_index(sc, "IntersectionD") == 3);
 
     printf("test_getIntersections passed\n");
 }
 
 int main() {
-    TrainEntry trains[LINE_MAX];
-    int trainCount = getTrains(trains);
+    Scenario sc;
+    assert(scenario_init(&sc) == 0);
+    int intersectionCount = getIntersections(&sc);
+    int trainCount = getTrains(&sc);
 
     // Print individual train entries
     printf("Train Entries:\n");
     for (int i = 0; i < trainCount; i++) {
-        for (int j = 0; j < trains[i].routeLength; j++) {
-            printf("%s%s", trains[i].route[j], (j < trains[i].routeLength - 1) ? " -> " : "");
+        TrainEntry te = scenario_train(&sc, i);
+        for (int j = 0; j < te.routeLength; j++) {
+            printf("%s%s", scenario_name(&sc, te.route[j]), (j < te.routeLength - 1) ? " -> " : "");
         }
     }
 
-    // Print all train entries
-    IntersectionEntry intersections[LINE_MAX];
-    int intersectionCount = getIntersections(intersections);
     // Print individual intersection entries
     printf("Intersection Entries:\n");
     for (int i = 0; i < intersectionCount; i++) {
-        printf("Intersection ID: %s, Capacity: %d, Available: %d\n", intersections[i].id, intersections[i].capacity, intersections[i].available);
+        printf("Intersection ID: %s, Capacity: %d\n", scenario_name(&sc, i), sc.intersections[i].capacity);
     }
     // Run unit tests
 
-    test_getTrains();
-    test_getIntersections();
+    test_getTrains(&sc);
+    test_getIntersections(&sc);
+    scenario_free(&sc);
     printf("All unit tests passed.\n");
     return 0;
 }
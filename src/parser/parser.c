@@ -5,14 +5,18 @@ Email: jarett.woodard@okstate.edu
 Date: 4.4.2025
 */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "parser.h"
-
-#define LINE_MAX 256
-#define ITEM_COUNT_MAX 64
-#define ITEM_CHAR_MAX 64
+#include "scenario_image.h"
 
 /*
   This modle will generate train and intersection structs for manipulation elsewhere
@@ -25,117 +29,653 @@ Date: 4.4.2025
 
   Instructions:
   use #include "parser.h" to include this module in your code.
-  Call the getTrains() and getIntersections() functions to get the train and intersection
+  Call scenario_init() and then getIntersections() and getTrains(), or scenario_load()
+  with explicit paths. Routes come back as intersection ids; scenario_train() gives a
+  train's name and route, scenario_name() turns an id back into its name.
 
   functions:
-  - static int parseTrainsFile(const char *filepath, TrainEntry trains[]) - parses the train file and returns the number of trains
-  - int getTrains(TrainEntry trains[]) - returns an array of TrainEntry structs
-  - void printTrainEntries(const TrainEntry trains[], int count) - prints the train entries for debugging
-  
-  - static int parseIntersectionsFile(const char *filepath, IntersectionEntry intersections[]) - parses the intersection file and returns the number of intersections
-  - int parseTrainLine(char *line, TrainEntry *train) - parses a line from the train file and returns a TrainEntry struct
-  - void printIntersectionEntries(const IntersectionEntry intersections[], int count) - prints the intersection entries for debugging
+  - int scenario_load(Scenario *sc, const char *trains_path, const char *intersections_path) - parses both files, reports malformed lines with their line number
+  - int scenario_parse_trains / scenario_parse_intersections(Scenario *sc, const char *path) - parses one file into sc
+  - int scenario_parse_trains_threads(Scenario *sc, const char *path, int threads) - the same with a set number of threads
+  - void scenario_free(Scenario *sc) - frees everything the scenario holds
+  - int getScenario(Scenario *sc) - maps $RAIL_SCENARIO (a railc image) or parses both default files
+  - int scenario_open(Scenario *sc, const char *image, const char *trains_path, const char *intersections_path) - the same with explicit paths
+  - int scenario_open_intersections(...) - scenario_open's intersections alone, to re-read capacities
+  - int scenario_add_train(Scenario *sc, const char *text, size_t len, const char *source, int line) - one more train line
+  - int getTrains(Scenario *sc) - parses text_files/trains.txt, returns the number of trains
+  - int getIntersections(Scenario *sc) - parses text_files/intersections.txt, returns the number of intersections
+  - int find_intersection_index(const Scenario *sc, const char *name) - index of an intersection, -1 if unknown
+  - void printTrainEntries(const Scenario *sc, int max) - prints the train entries for debugging
+  - void printIntersectionEntries(const Scenario *sc) - prints the intersection entries for debugging
 */
 
-// TRAIN PARSER
+// SCENARIO PARSER
+
+// Both files are mapped read-only and scanned in place with memchr: one pass finds
+// each line, the ':' and the ','s inside it. Fields are never copied or terminated,
+// they go straight to the name table as pointer and length, so only the first sight
+// of each distinct name costs a copy. The arrays are allocated once per file, at an
+// upper bound taken from the file size.
+
+
+#define PARSE_ERRORS_SHOWN 20           // the rest are only counted
+#define PARSE_ERROR_TEXT 200
+#define CAPACITY_MAX 1000000
+
+typedef struct {
+    const char *data;
+    size_t size;
+} MappedFile;
+
+typedef struct {
+    int line;
+    char text[PARSE_ERROR_TEXT];
+} ParseMessage;
+
+// Messages are held back and printed by parseDone() in line order, so a file parsed
+// in chunks reports what a serial parse would
+typedef struct {
+    const char *path;
+    int errors;
+    int shown;
+    ParseMessage msgs[PARSE_ERRORS_SHOWN];  // the earliest lines seen so far
+} ParseErrors;
+
+static int mapFile(const char *path, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        fprintf(stderr, "Error reading %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "Error mapping %s: %s\n", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        file->data = data;
+        file->size = st.st_size;
+    }
+    close(fd);
+    return 0;
+}
+
+static void unmapFile(MappedFile *file) {
+    if (file->data) munmap((void *)file->data, file->size);
+    file->data = NULL;
+}
+
+// keeps the PARSE_ERRORS_SHOWN earliest lines; merged chunks arrive out of order
+static void keepMessage(ParseErrors *pe, int line, const char *text) {
+    int slot = pe->shown;
+    if (slot == PARSE_ERRORS_SHOWN) {
+        slot = 0;
+        for (int i = 1; i < pe->shown; i++) {
+            if (pe->msgs[i].line > pe->msgs[slot].line) slot = i;
+        }
+        if (line >= pe->msgs[slot].line) return;
+    } else {
+        pe->shown++;
+    }
+    pe->msgs[slot].line = line;
+    snprintf(pe->msgs[slot].text, PARSE_ERROR_TEXT, "%s", text);
+}
+
+static void parseError(ParseErrors *pe, int line, const char *fmt, ...) {
+    pe->errors++;
+    char text[PARSE_ERROR_TEXT];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    keepMessage(pe, line, text);
+}
+
+static int compareMessages(const void *a, const void *b) {
+    return ((const ParseMessage *)a)->line - ((const ParseMessage *)b)->line;
+}
+
+static int parseDone(ParseErrors *pe) {
+    qsort(pe->msgs, pe->shown, sizeof(ParseMessage), compareMessages);
+    for (int i = 0; i < pe->shown; i++) fprintf(stderr, "%s:%d: %s\n", pe->path, pe->msgs[i].line, pe->msgs[i].text);
+    if (pe->errors > PARSE_ERRORS_SHOWN) {
+        fprintf(stderr, "%s: %d more errors not shown\n", pe->path, pe->errors - PARSE_ERRORS_SHOWN);
+    }
+    if (pe->errors) fprintf(stderr, "%s: %d malformed line(s)\n", pe->path, pe->errors);
+    return pe->errors ? -1 : 0;
+}
+
+// drops blanks, tabs and the '\r' of CRLF files from both ends of [*s, *e)
+static inline void trimField(const char **s, const char **e) {
+    while (*s < *e && (**s == ' ' || **s == '\t' || **s == '\r')) (*s)++;
+    while (*e > *s && ((*e)[-1] == ' ' || (*e)[-1] == '\t' || (*e)[-1] == '\r')) (*e)--;
+}
+
+
+// Upper bounds for the arrays, from the file size alone: the shortest train line is
+// "T:A\n", so there is at most one train per 4 bytes, and every hop takes at least
+// a character and a separator. The arena maps the bound without reserving it, and
+// only the pages the parse actually fills are ever backed by memory.
+static size_t maxRecords(const MappedFile *file) {
+    return file->size / 4 + 1;
+}
+
+static size_t maxHops(const MappedFile *file) {
+    return file->size / 2 + 1;
+}
 
-// Each line from trains.txt will parse into an instance of this struct
-static int parseTrainsFile(const char *filepath, TrainEntry trains[]) {
-    FILE *file = fopen(filepath, "r");
-    if (!file) {
-        perror("Error opening train file");
+int scenario_init(Scenario *sc) {
+    memset(sc, 0, sizeof(*sc));
+    arena_init(&sc->arena);
+    if (names_init(&sc->names) == -1 || names_init(&sc->train_names) == -1) {
+        scenario_free(sc);
         return -1;
     }
+    // train 0 starts at hop 0 even before any trains are parsed
+    sc->route_offset = arena_alloc(&sc->arena, sizeof(uint32_t));
+    if (!sc->route_offset) {
+        scenario_free(sc);
+        return -1;
+    }
+    return 0;
+}
 
-    char line[LINE_MAX];
-    int count = 0;
+void scenario_free(Scenario *sc) {
+    if (sc->image) {
+        // a mapped image owns every array, names included
+        munmap((void *)sc->image, sc->image_size);
+        memset(sc, 0, sizeof(*sc));
+        return;
+    }
+    names_free(&sc->names);
+    names_free(&sc->train_names);
+    arena_free(&sc->arena);
+    memset(sc, 0, sizeof(*sc));
+}
 
-    while (fgets(line, sizeof(line), file) && count < LINE_MAX) {
-        line[strcspn(line, "\n")] = '\0';
+// Name:capacity, capacity a positive integer
+static void parseIntersectionLine(Scenario *sc, ParseErrors *pe, int line, const char *p, const char *eol) {
+    const char *colon = memchr(p, ':', eol - p);
+    if (!colon) {
+        parseError(pe, line, "expected Intersection:capacity, found no ':'");
+        return;
+    }
+    const char *name = p, *name_end = colon;
+    const char *cap = colon + 1, *cap_end = eol;
+    trimField(&name, &name_end);
+    trimField(&cap, &cap_end);
+    if (name == name_end) {
+        parseError(pe, line, "missing intersection name");
+        return;
+    }
 
-        char *id = strtok(line, ":");
-        char *valueStr = strtok(NULL, ":");
+    long capacity = 0;
+    const char *c = cap;
+    while (c < cap_end && *c >= '0' && *c <= '9' && capacity <= CAPACITY_MAX) capacity = capacity * 10 + (*c++ - '0');
+    if (cap == cap_end || c != cap_end || capacity < 1 || capacity > CAPACITY_MAX) {
+        parseError(pe, line, "capacity of %.*s must be an integer from 1 to %d, found '%.*s'",
+                   (int)(name_end - name), name, CAPACITY_MAX, (int)(cap_end - cap), cap);
+        return;
+    }
 
-        if (id && valueStr) {
-            strncpy(trains[count].id, id, ITEM_CHAR_MAX - 1);
-            trains[count].id[ITEM_CHAR_MAX - 1] = '\0';
-            trains[count].routeLength = 0;
+    int id = names_intern(&sc->names, name, name_end - name);
+    if (id == -1) {
+        pe->errors++;
+        return;
+    }
+    if (id < sc->intersection_count) {
+        parseError(pe, line, "duplicate intersection %.*s, first defined on line %d",
+                   (int)(name_end - name), name, sc->intersections[id].line);
+        return;
+    }
+    if (id != sc->intersection_count) {
+        parseError(pe, line, "%.*s was named by a route before the intersections were parsed",
+                   (int)(name_end - name), name);
+        return;
+    }
+    sc->intersections[id].capacity = (int)capacity;
+    sc->intersections[id].line = line;
+    sc->intersection_count++;
+}
 
-            char *token = strtok(valueStr, ",");
-            while (token && trains[count].routeLength < ITEM_COUNT_MAX) {
-                strncpy(trains[count].route[trains[count].routeLength], token, ITEM_CHAR_MAX - 1);
-                trains[count].route[trains[count].routeLength][ITEM_CHAR_MAX - 1] = '\0';
-                trains[count].routeLength++;
-                token = strtok(NULL, ",");
-            }
+// Name:hop,hop,...  with at least one hop and no empty ones
+static void parseTrainLine(Scenario *sc, ParseErrors *pe, int line, const char *p, const char *eol) {
+    const char *colon = memchr(p, ':', eol - p);
+    if (!colon) {
+        parseError(pe, line, "expected Train:Intersection,Intersection,... found no ':'");
+        return;
+    }
+    const char *name = p, *name_end = colon;
+    trimField(&name, &name_end);
+    if (name == name_end) {
+        parseError(pe, line, "missing train name");
+        return;
+    }
+    const char *route = colon + 1;
+    if (memchr(route, ':', eol - route)) {
+        parseError(pe, line, "more than one ':' in the line");
+        return;
+    }
 
-            count++;
+    // hops go after the last route and only count once the whole line is good;
+    // maxHops() made room for all of them
+    uint32_t start = sc->route_offset[sc->train_count];
+    uint32_t end = start;
+    int hops = 0;
+    for (const char *f = route; f <= eol; hops++) {
+        const char *comma = memchr(f, ',', eol - f);
+        const char *f_end = comma ? comma : eol;
+        const char *s = f, *e = f_end;
+        trimField(&s, &e);
+        if (s == e) {
+            if (hops == 0 && !comma) parseError(pe, line, "train %.*s has an empty route", (int)(name_end - name), name);
+            else parseError(pe, line, "empty intersection name at hop %d of %.*s", hops + 1, (int)(name_end - name), name);
+            return;
         }
+        int id = names_intern(&sc->names, s, e - s);
+        if (id == -1) {
+            pe->errors++;
+            return;
+        }
+        sc->route_ids[end++] = id;
+        f = f_end + 1;
+    }
+
+    int before = sc->train_names.count;
+    int train_name = names_intern(&sc->train_names, name, name_end - name);
+    if (train_name == -1) {
+        pe->errors++;
+        return;
+    }
+    if (train_name < before) {
+        parseError(pe, line, "duplicate train %.*s, first defined on line %d",
+                   (int)(name_end - name), name, sc->train_line[train_name]);
+        return;
     }
+    // train name id == train index
+    sc->train_line[sc->train_count] = line;
+    sc->route_offset[++sc->train_count] = end;
+}
+
+typedef void (*LineParser)(Scenario *sc, ParseErrors *pe, int line, const char *p, const char *eol);
 
-    fclose(file);
-    return count;
+// calls parse_line for every line that is not blank; line is the count of lines
+// before file->data, which is not the start of the file for a chunk
+static void parseLines(Scenario *sc, const MappedFile *file, ParseErrors *pe, LineParser parse_line, int line) {
+    const char *p = file->data, *end = file->data + file->size;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        const char *eol = nl ? nl : end;
+        line++;
+        const char *s = p, *e = eol;
+        trimField(&s, &e);
+        if (s < e) parse_line(sc, pe, line, p, eol);
+        p = nl ? nl + 1 : end;
+    }
 }
 
-// Getter function for train entries. returns an array of TrainEntry structs
-int getTrains(TrainEntry trains[]) {
-    return parseTrainsFile("text_files/trains.txt", trains);
+// grows an array into the arena, keeping the first used entries
+static void *arenaGrow(Arena *arena, const void *old, size_t used, size_t count, size_t size) {
+    void *grown = arena_alloc(arena, count * size);
+    if (grown && used) memcpy(grown, old, used * size);
+    return grown;
 }
-// Function to print the train entries for debugging
-void printTrainEntries(const TrainEntry trains[], int count) {
+
+int scenario_parse_intersections(Scenario *sc, const char *path) {
+    MappedFile file;
+    if (mapFile(path, &file) == -1) return -1;
+    sc->intersections = arenaGrow(&sc->arena, sc->intersections, sc->intersection_count,
+                                  sc->intersection_count + maxRecords(&file), sizeof(ScenarioIntersection));
+    ParseErrors pe = { .path = path };
+    int rc = -1;
+    if (sc->intersections) {
+        parseLines(sc, &file, &pe, parseIntersectionLine, 0);
+        rc = parseDone(&pe);
+    }
+    unmapFile(&file);
+    return rc;
+}
+
+// room for lines more trains and hops more hops after the ones sc already has
+static int reserveTrains(Scenario *sc, size_t lines, size_t hops, const char *path) {
+    size_t used = sc->route_offset[sc->train_count];
+    if (used + hops > UINT32_MAX || sc->train_count + lines > INT32_MAX) {
+        fprintf(stderr, "%s: too many trains or hops for one scenario\n", path);
+        return -1;
+    }
+    sc->route_offset = arenaGrow(&sc->arena, sc->route_offset, sc->train_count + 1,
+                                 sc->train_count + lines + 1, sizeof(uint32_t));
+    sc->route_ids = arenaGrow(&sc->arena, sc->route_ids, used, used + hops, sizeof(int));
+    sc->train_line = arenaGrow(&sc->arena, sc->train_line, sc->train_count, sc->train_count + lines, sizeof(int));
+    sc->train_cap = sc->train_count + lines;
+    sc->route_cap = used + hops;
+    return sc->route_offset && sc->route_ids && sc->train_line ? 0 : -1;
+}
+
+static int parseTrainsSerial(Scenario *sc, const MappedFile *file, const char *path) {
+    if (reserveTrains(sc, maxRecords(file), maxHops(file), path) == -1) return -1;
+    ParseErrors pe = { .path = path };
+    parseLines(sc, file, &pe, parseTrainLine, 0);
+    return parseDone(&pe);
+}
+
+// PARALLEL TRAINS
+
+// A big trains file is cut into chunks at line boundaries and a few threads parse
+// them, each chunk into a Scenario of its own: private name tables, private arena,
+// local ids in first-seen order. The chunks are then merged in file order, interning
+// each chunk's names into sc in local id order. A name gets its id the first time a
+// chunk that has it is merged, in the order that chunk first saw it, which is the
+// order a serial parse would have met it, so the ids, the train order and the
+// line numbers do not depend on the number of threads.
+
+#define PARALLEL_MIN_BYTES (4 << 20)    // below this the threads cost more than they save
+#define CHUNKS_PER_THREAD 4             // so one slow chunk does not hold up the rest
+#define PARSE_THREADS_MAX 64
+
+typedef struct {
+    MappedFile text;            // whole lines
+    int lines;                  // '\n's in text
+    int first_line;             // lines of the file before text
+    Scenario local;
+    ParseErrors pe;
+    int failed;                 // out of memory, already reported
+    Scenario *into;             // set by the merge: where the chunk's trains go,
+    int *global;                // the chunk's name ids -> sc's
+    int first_train;            // index in sc of the chunk's first train
+    uint32_t first_hop;
+} TrainChunk;
+
+typedef struct {
+    TrainChunk *chunks;
+    int count;
+    int next;                   // next chunk to hand out, taken atomically
+    void (*work)(TrainChunk *c);
+} ChunkPool;
+
+static void *chunkWorker(void *arg) {
+    ChunkPool *pool = arg;
+    int i;
+    while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count) pool->work(&pool->chunks[i]);
+    return NULL;
+}
+
+// runs work on every chunk on up to threads threads, the caller's included
+static void runChunks(ChunkPool *pool, int threads, void (*work)(TrainChunk *c)) {
+    pthread_t tids[PARSE_THREADS_MAX];
+    int started = 0;
+    pool->next = 0;
+    pool->work = work;
+    while (started < threads - 1 && pthread_create(&tids[started], NULL, chunkWorker, pool) == 0) started++;
+    chunkWorker(pool);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+}
+
+static void countChunkLines(TrainChunk *c) {
+    const char *p = c->text.data, *end = p + c->text.size;
+    while ((p = memchr(p, '\n', end - p))) {
+        c->lines++;
+        p++;
+    }
+}
+
+static void parseChunk(TrainChunk *c) {
+    if (scenario_init(&c->local) == -1 ||
+        reserveTrains(&c->local, maxRecords(&c->text), maxHops(&c->text), c->pe.path) == -1) {
+        c->failed = 1;
+        return;
+    }
+    parseLines(&c->local, &c->text, &c->pe, parseTrainLine, c->first_line);
+}
+
+// Merging, part one, in file order: gives the chunk's names their ids in sc and its
+// trains their place, dropping any that repeat an earlier chunk's train
+static int mergeChunkNames(Scenario *sc, TrainChunk *c, ParseErrors *pe) {
+    Scenario *local = &c->local;
+    c->global = malloc((local->names.count + 1) * sizeof(int));
+    if (!c->global) {
+        perror("scenario_parse_trains");
+        return -1;
+    }
+    for (int id = 0; id < local->names.count; id++) {
+        c->global[id] = names_intern_hashed(&sc->names, names_get(&local->names, id),
+                                            names_len(&local->names, id), local->names.hash[id]);
+        if (c->global[id] == -1) return -1;
+    }
+
+    c->into = sc;
+    c->first_train = sc->train_count;
+    c->first_hop = sc->route_offset[sc->train_count];
+    uint32_t hops = c->first_hop;
+    for (int t = 0; t < local->train_count; t++) {
+        const char *name = names_get(&local->train_names, t);
+        int before = sc->train_names.count;
+        int train_name = names_intern_hashed(&sc->train_names, name, names_len(&local->train_names, t),
+                                             local->train_names.hash[t]);
+        if (train_name == -1) return -1;
+        // the chunk caught its own duplicates, this is one of an earlier chunk's trains
+        if (train_name < before) {
+            parseError(&c->pe, local->train_line[t], "duplicate train %s, first defined on line %d",
+                       name, sc->train_line[train_name]);
+            local->train_line[t] = 0;
+            continue;
+        }
+        // the line is all mergeChunkRoutes() needs before it has run
+        sc->train_line[sc->train_count++] = local->train_line[t];
+        hops += local->route_offset[t + 1] - local->route_offset[t];
+    }
+    sc->route_offset[sc->train_count] = hops;
+
+    pe->errors += c->pe.errors;
+    for (int i = 0; i < c->pe.shown; i++) keepMessage(pe, c->pe.msgs[i].line, c->pe.msgs[i].text);
+    return 0;
+}
+
+// part two, chunks in parallel: the routes, in sc's ids, into the place part one gave them
+static void mergeChunkRoutes(TrainChunk *c) {
+    const Scenario *local = &c->local;
+    const int *global = c->global, *in = local->route_ids;
+    uint32_t *offset = c->into->route_offset + c->first_train;
+    int *out = c->into->route_ids;
+    uint32_t end = c->first_hop;
+    int kept = 0;
+    for (int t = 0; t < local->train_count; t++) {
+        if (!local->train_line[t]) continue;    // dropped by part one
+        uint32_t to = local->route_offset[t + 1];
+        for (uint32_t h = local->route_offset[t]; h < to; h++) out[end++] = global[in[h]];
+        offset[++kept] = end;
+    }
+}
+
+static int parseTrainsParallel(Scenario *sc, const MappedFile *file, const char *path, int threads) {
+    int count = threads * CHUNKS_PER_THREAD;
+    TrainChunk *chunks = calloc(count, sizeof(TrainChunk));
+    if (!chunks) {
+        perror("scenario_parse_trains");
+        return -1;
+    }
+    // each chunk ends just after the first '\n' past its share of the file
+    const char *p = file->data, *end = file->data + file->size;
     for (int i = 0; i < count; i++) {
-        printf("Train: %s\n", trains[i].id);
-        for (int j = 0; j < trains[i].routeLength; j++) {
-            printf("  Route %d: %s\n", j + 1, trains[i].route[j]);
+        const char *stop = end;
+        if (i < count - 1) {
+            stop = file->data + file->size / count * (i + 1);
+            if (stop < p) stop = p;
+            const char *nl = memchr(stop, '\n', end - stop);
+            stop = nl ? nl + 1 : end;
         }
+        chunks[i].text.data = p;
+        chunks[i].text.size = stop - p;
+        chunks[i].pe.path = path;
+        p = stop;
     }
-    printf("\n");
+
+    // line numbers first, so every chunk reports the file's own
+    ChunkPool pool = { chunks, count, 0, NULL };
+    runChunks(&pool, threads, countChunkLines);
+    for (int i = 0, line = 0; i < count; i++) {
+        chunks[i].first_line = line;
+        line += chunks[i].lines;
+    }
+    runChunks(&pool, threads, parseChunk);
+
+    // the chunks' exact totals, now that they are known
+    size_t trains = 0, hops = 0, text = sc->train_names.text_len;
+    int rc = 0;
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].failed) {
+            rc = -1;
+            continue;
+        }
+        trains += chunks[i].local.train_count;
+        hops += chunks[i].local.route_offset[chunks[i].local.train_count];
+        text += chunks[i].local.train_names.text_len;
+    }
+    if (rc == 0) rc = reserveTrains(sc, trains, hops, path);
+    if (rc == 0) rc = names_reserve(&sc->train_names, sc->train_names.count + trains, text);
+    ParseErrors pe = { .path = path };
+    for (int i = 0; i < count && rc == 0; i++) rc = mergeChunkNames(sc, &chunks[i], &pe);
+    if (rc == 0) runChunks(&pool, threads, mergeChunkRoutes);
+    for (int i = 0; i < count; i++) {
+        scenario_free(&chunks[i].local);
+        free(chunks[i].global);
+    }
+    free(chunks);
+    return rc == -1 ? -1 : parseDone(&pe);
+}
+
+// $RAIL_PARSE_THREADS, or one per CPU for files big enough to be worth it
+static int parseThreads(const MappedFile *file) {
+    const char *env = getenv("RAIL_PARSE_THREADS");
+    if (env && *env) return atoi(env);
+    if (file->size < PARALLEL_MIN_BYTES) return 1;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
 }
 
-//INTERSECTION PARSER
+int scenario_parse_trains(Scenario *sc, const char *path) {
+    return scenario_parse_trains_threads(sc, path, 0);
+}
 
-// Function to print the intersection entries for debugging
-static int parseIntersectionsFile(const char *filepath, IntersectionEntry intersections[]) {
-    FILE *file = fopen(filepath, "r");
-    if (!file) {
-        perror("Error opening intersection file");
+int scenario_parse_trains_threads(Scenario *sc, const char *path, int threads) {
+    MappedFile file;
+    if (mapFile(path, &file) == -1) return -1;
+    if (threads <= 0) threads = parseThreads(&file);
+    if (threads > PARSE_THREADS_MAX) threads = PARSE_THREADS_MAX;
+    int rc = threads > 1 ? parseTrainsParallel(sc, &file, path, threads) : parseTrainsSerial(sc, &file, path);
+    unmapFile(&file);
+    return rc;
+}
+
+int scenario_load(Scenario *sc, const char *trains_path, const char *intersections_path) {
+    if (scenario_init(sc) == -1) return -1;
+    // both files are checked so one run reports every problem
+    int rc = scenario_parse_intersections(sc, intersections_path);
+    if (scenario_parse_trains(sc, trains_path) == -1) rc = -1;
+    if (rc == -1) scenario_free(sc);
+    return rc;
+}
+
+int scenario_add_train(Scenario *sc, const char *text, size_t len, const char *source, int line) {
+    if (sc->image) {
+        fprintf(stderr, "%s:%d: cannot add a train to a mapped scenario image\n", source, line);
         return -1;
     }
+    MappedFile one = { text, len };
+    size_t used = sc->route_offset[sc->train_count];
+    if ((size_t)sc->train_count + 1 > sc->train_cap || used + maxHops(&one) > sc->route_cap) {
+        // at least doubles, so a long stream of single lines costs linear time
+        size_t trains = sc->train_count > 64 ? sc->train_count : 64;
+        size_t hops = used > maxHops(&one) ? used : maxHops(&one);
+        if (reserveTrains(sc, trains, hops, source) == -1) return -1;
+    }
+    ParseErrors pe = { .path = source };
+    parseTrainLine(sc, &pe, line, text, text + len);
+    return parseDone(&pe) == -1 ? -1 : sc->train_count - 1;
+}
+
+// Getter function for the whole scenario: the compiled image named by RAIL_SCENARIO,
+// or both default text files
+int getScenario(Scenario *sc) {
+    return scenario_open(sc, NULL, NULL, NULL);
+}
+
+// the image scenario_open() maps for these arguments, NULL when it reads the text files
+static const char *openedImage(const char *image, const char *trains_path, const char *intersections_path) {
+    if (image) return image;
+    // text files named on the command line win over the environment's image
+    const char *env_image = getenv("RAIL_SCENARIO");
+    if (!trains_path && !intersections_path && env_image && *env_image) return env_image;
+    return NULL;
+}
 
-    char line[LINE_MAX];
-    int count = 0;
+int scenario_open(Scenario *sc, const char *image, const char *trains_path, const char *intersections_path) {
+    const char *opened = openedImage(image, trains_path, intersections_path);
+    if (opened) return scenario_map_image(sc, opened);
+    return scenario_load(sc, trains_path ? trains_path : TRAINS_FILE,
+                         intersections_path ? intersections_path : INTERSECTIONS_FILE);
+}
 
-    while (fgets(line, sizeof(line), file) && count < LINE_MAX) {
-        line[strcspn(line, "\n")] = '\0';
+int scenario_open_intersections(Scenario *sc, const char *image, const char *trains_path,
+                                const char *intersections_path) {
+    const char *opened = openedImage(image, trains_path, intersections_path);
+    if (opened) return scenario_map_image(sc, opened);
+    if (scenario_init(sc) == -1) return -1;
+    if (scenario_parse_intersections(sc, intersections_path ? intersections_path : INTERSECTIONS_FILE) == -1) {
+        scenario_free(sc);
+        return -1;
+    }
+    return 0;
+}
 
-        char *id = strtok(line, ":");
-        char *capStr = strtok(NULL, ":");
+// TRAIN ENTRIES
 
-        if (id && capStr) {
-            strncpy(intersections[count].id, id, ITEM_CHAR_MAX - 1);
-            intersections[count].id[ITEM_CHAR_MAX - 1] = '\0';
+// Getter function for train entries, parses the default trains file into sc
+int getTrains(Scenario *sc) {
+    return scenario_parse_trains(sc, TRAINS_FILE) == -1 ? -1 : sc->train_count;
+}
 
-            intersections[count].capacity = atoi(capStr);
-            intersections[count].available = intersections[count].capacity;
-            count++;
+// Function to print the train entries for debugging
+void printTrainEntries(const Scenario *sc, int max) {
+    for (int i = 0; i < sc->train_count && i < max; i++) {
+        TrainEntry te = scenario_train(sc, i);
+        printf("Train: %s\n", te.id);
+        for (int j = 0; j < te.routeLength; j++) {
+            printf("  Route %d: %s\n", j + 1, scenario_name(sc, te.route[j]));
         }
     }
+    if (sc->train_count > max) printf("... and %d more trains\n", sc->train_count - max);
+    printf("\n");
+}
+
+// INTERSECTION ENTRIES
 
-    fclose(file);
-    return count;
+// Getter function for intersection entries, parses the default intersections file into sc
+int getIntersections(Scenario *sc) {
+    return scenario_parse_intersections(sc, INTERSECTIONS_FILE) == -1 ? -1 : sc->intersection_count;
 }
 
-// Getter function for train entries
-int getIntersections(IntersectionEntry intersections[]) {
-    return parseIntersectionsFile("text_files/intersections.txt", intersections);
+// helper to map intersection name to its index, -1 if unknown
+int find_intersection_index(const Scenario *sc, const char *name) {
+    int id = names_find(&sc->names, name, strlen(name));
+    return id < sc->intersection_count ? id : -1;
 }
 
 // Function to print the intersection entries for debugging
-void printIntersectionEntries(const IntersectionEntry intersections[], int count) {
-    for (int i = 0; i < count; i++) {
-        printf("Intersection: %s\n", intersections[i].id);
-        printf("  Capacity:  %d\n", intersections[i].capacity);
-        printf("  Available: %d\n", intersections[i].available);
+void printIntersectionEntries(const Scenario *sc) {
+    for (int i = 0; i < sc->intersection_count; i++) {
+        printf("Intersection: %s\n", scenario_name(sc, i));
+        printf("  Capacity:  %d\n", sc->intersections[i].capacity);
     }
     printf("\n");
-}
\ No newline at end of file
+}
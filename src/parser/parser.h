@@ -7,53 +7,130 @@ Date: 4.4.2025
 #ifndef PARSER_H
 #define PARSER_H
 
-#define ITEM_CHAR_MAX 64
-#define ITEM_COUNT_MAX 64
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "intern.h"
+
 #define LINE_MAX 256
 
+#define TRAINS_FILE        "text_files/trains.txt"
+#define INTERSECTIONS_FILE "text_files/intersections.txt"
+
 /* This is the header file for the parser module.
 */
 
-/* Struct to hold one train ID and its route (sequence of intersection names)
-Ex. Train1:IntersectionA,IntersectionB,IntersectionC
-This parses to
-id = "Train1"
-route[0] = "IntersectionA"
-route[1] = "IntersectionB"
-route[2] = "IntersectionC"
-...
-route[64] = "Intersection_N"
+/* Parsed scenario. Both files are mapped and scanned in place; every name is
+interned once (intern.h), so a route is a list of intersection ids rather than
+copies of the names.
+
+Routes are stored in compressed sparse row form: the hops of every train back to
+back in route_ids, and train t's hops are route_ids[route_offset[t]] up to
+route_offset[t + 1]. There is no cap on route length or name size, and a train costs
+its hops at 4 bytes each plus 8 bytes, instead of a 4 KB TrainEntry. The arrays are
+carved out of the arena in one piece per file, sized from the file's length, and
+forked processes share them copy-on-write.
+
+Ex. intersections.txt        trains.txt
+    IntersectionA:1          Train1:IntersectionA,IntersectionB,IntersectionC
+    IntersectionB:2          Train2:IntersectionB,IntersectionC
+    IntersectionC:1
+parses to
+    names        = IntersectionA, IntersectionB, IntersectionC (ids 0, 1, 2)
+    capacity     = 1, 2, 1
+    train_names  = Train1, Train2 (train t has name id t)
+    route_ids    = 0, 1, 2, 1, 2
+    route_offset = 0, 3, 5
 
+Intersection ids 0..intersection_count-1 are intersections.txt in file order, which
+is also the index the server uses for shared memory. A route may name an
+intersection the file does not have; it gets a higher id and the server FAILs it at
+run time, as before.
 */
 typedef struct {
-    char id[ITEM_CHAR_MAX];                             // Train name (e.g., "Train1")
-    char route[ITEM_COUNT_MAX][ITEM_CHAR_MAX];          // Ordered intersection list
-    int routeLength;                                    // Number of intersections
-} TrainEntry;
+    int capacity;
+    int line;                   // line in intersections.txt, for error messages
+} ScenarioIntersection;
+
+typedef struct {
+    NameTable names;            // intersections first, then anything else a route names
+    ScenarioIntersection *intersections;
+    int intersection_count;
 
-/* Struct to hold one intersection's ID, capacity, and runtime available spots
-ex. IntersectionA:1
-This parses to
-id = "IntersectionA"
-capacity = 1
-available = 1
+    NameTable train_names;
+    int train_count;
+    uint32_t *route_offset;     // train_count + 1 entries
+    int *route_ids;
+    int *train_line;            // line in trains.txt of each train
+    size_t train_cap, route_cap; // room in the arrays, for scenario_add_train()
 
-initial condition is that available = capacity. Capcity can be reduced as trains
-occupy the intersection. An initial capcity of 1 indicates a mutex. An initial
-capacity of >1 indicates a semaphore.
+    Arena arena;                // everything above except the name tables
+    const void *image;          // set when everything above points into a mapped
+    size_t image_size;          // scenario image instead (scenario_image.h)
+} Scenario;
+
+/* One train, as a view into the scenario (valid as long as the scenario is)
+Ex. Train1:IntersectionA,IntersectionB,IntersectionC
+id = "Train1", route = { 0, 1, 2 }, routeLength = 3
 */
 typedef struct {
-    char id[ITEM_CHAR_MAX];
-    int capacity;
-    int available;
-} IntersectionEntry;
+    const char *id;             // Train name (e.g., "Train1")
+    const int *route;           // Ordered intersection ids, names from scenario_name()
+    int routeLength;            // Number of intersections
+} TrainEntry;
+
+// Each returns 0, or -1 after printing every problem as file:line: message on
+// stderr. Malformed lines are reported, never skipped or truncated.
+int  scenario_init(Scenario *sc);
+void scenario_free(Scenario *sc);
+// intersections must be parsed before trains so they get the low ids
+int  scenario_parse_intersections(Scenario *sc, const char *path);
+int  scenario_parse_trains(Scenario *sc, const char *path);
+// Files of 4 MB and up are parsed in chunks on one thread per CPU, or on
+// $RAIL_PARSE_THREADS threads if that is set; the result is the same either way.
+// threads > 0 overrides both, 1 is the plain serial parse
+int  scenario_parse_trains_threads(Scenario *sc, const char *path, int threads);
+// init plus both files
+int  scenario_load(Scenario *sc, const char *trains_path, const char *intersections_path);
+// Adds one "Train:hop,hop,..." line, given without its newline, as the next train,
+// e.g. for trains that arrive while the simulation runs. source and line are only
+// for the error message. Returns the new train's index, or -1
+int  scenario_add_train(Scenario *sc, const char *text, size_t len, const char *source, int line);
+
+static inline const char *scenario_name(const Scenario *sc, int id) {
+    return names_get(&sc->names, id);
+}
+
+static inline int scenario_route_length(const Scenario *sc, int train) {
+    return (int)(sc->route_offset[train + 1] - sc->route_offset[train]);
+}
+
+static inline TrainEntry scenario_train(const Scenario *sc, int train) {
+    TrainEntry te = { names_get(&sc->train_names, train), sc->route_ids + sc->route_offset[train],
+                      scenario_route_length(sc, train) };
+    return te;
+}
 
-// functions to call from main
-int getTrains(TrainEntry trains[]);
-int getIntersections(IntersectionEntry intersections[]);
+// functions to call from main. getScenario() maps the compiled image named by
+// RAIL_SCENARIO if it is set (see railc), and otherwise parses the two default text
+// files; it returns 0 or -1. For the other two, sc comes from scenario_init(); each
+// returns the number of trains or intersections parsed, or -1
+int getScenario(Scenario *sc);
+// getScenario() with paths from the command line: an image if one is given, else the
+// text files, with the default for whichever path is NULL. With all three NULL it is
+// getScenario()
+int scenario_open(Scenario *sc, const char *image, const char *trains_path, const char *intersections_path);
+// scenario_open() from the same source, but a text scenario only reads its
+// intersections file, so capacities can be re-read without parsing the trains again
+int scenario_open_intersections(Scenario *sc, const char *image, const char *trains_path,
+                                const char *intersections_path);
+int getTrains(Scenario *sc);
+int getIntersections(Scenario *sc);
+// index of an intersection from intersections.txt, -1 if unknown
+int find_intersection_index(const Scenario *sc, const char *name);
 
-// Optional debug print functions
-void printTrainEntries(const TrainEntry trains[], int count);
-void printIntersectionEntries(const IntersectionEntry intersections[], int count);
+// Optional debug print functions; at most max trains are listed
+void printTrainEntries(const Scenario *sc, int max);
+void printIntersectionEntries(const Scenario *sc);
 
 #endif
@@ -0,0 +1,218 @@
+// scenario_image.c
+// Group: B
+// Date: 10-19-2026
+// Writing and mapping compiled scenario images, see scenario_image.h.
+#include "scenario_image.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IMAGE_ALIGN 64
+
+// WRITING
+
+typedef struct {
+    FILE *file;
+    uint64_t pos;
+} ImageWriter;
+
+// appends one section at the next aligned offset and stores that offset in *at
+static int putSection(ImageWriter *w, const void *data, size_t len, uint64_t *at) {
+    static const char zeros[IMAGE_ALIGN];
+    size_t pad = (IMAGE_ALIGN - w->pos % IMAGE_ALIGN) % IMAGE_ALIGN;
+    if (pad && fwrite(zeros, 1, pad, w->file) != pad) return -1;
+    w->pos += pad;
+    *at = w->pos;
+    if (len && fwrite(data, 1, len, w->file) != len) return -1;
+    w->pos += len;
+    return 0;
+}
+
+static int putNames(ImageWriter *w, const NameTable *t, ImageNames *out) {
+    out->count = t->count;
+    out->slot_count = t->slot_mask + 1;
+    out->text_len = t->text_len;
+    size_t ids = t->count * sizeof(uint32_t);
+    if (putSection(w, t->text, t->text_len, &out->text) == -1) return -1;
+    if (putSection(w, t->offset, ids, &out->offset) == -1) return -1;
+    if (putSection(w, t->length, ids, &out->length) == -1) return -1;
+    if (putSection(w, t->hash, ids, &out->hash) == -1) return -1;
+    return putSection(w, t->slots, out->slot_count * sizeof(int), &out->slots);
+}
+
+int scenario_write_image(const Scenario *sc, const char *path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%d", path, (int)getpid());
+    FILE *file = fopen(tmp, "wb");
+    if (!file) {
+        fprintf(stderr, "Error creating %s: %s\n", tmp, strerror(errno));
+        return -1;
+    }
+
+    ImageHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    h.version = IMAGE_VERSION;
+    h.header_size = sizeof(ImageHeader);
+    h.intersection_count = sc->intersection_count;
+    h.train_count = sc->train_count;
+    h.route_id_count = sc->route_offset[sc->train_count];
+
+    // the header goes first with the offsets still zero and is rewritten at the end
+    ImageWriter w = { file, 0 };
+    uint64_t at;
+    int rc = putSection(&w, &h, sizeof(h), &at);
+    if (rc == 0) rc = putNames(&w, &sc->names, &h.names);
+    if (rc == 0) rc = putNames(&w, &sc->train_names, &h.train_names);
+    if (rc == 0) rc = putSection(&w, sc->intersections, sc->intersection_count * sizeof(ScenarioIntersection), &h.intersections);
+    if (rc == 0) rc = putSection(&w, sc->route_offset, (sc->train_count + 1) * sizeof(uint32_t), &h.route_offset);
+    if (rc == 0) rc = putSection(&w, sc->route_ids, h.route_id_count * sizeof(int), &h.route_ids);
+    if (rc == 0) rc = putSection(&w, sc->train_line, sc->train_count * sizeof(int), &h.train_line);
+    h.size = w.pos;
+    if (rc == 0 && (fseek(file, 0, SEEK_SET) == -1 || fwrite(&h, sizeof(h), 1, file) != 1)) rc = -1;
+    if (fclose(file) == EOF) rc = -1;
+    if (rc == 0 && rename(tmp, path) == -1) rc = -1;
+    if (rc == -1) {
+        fprintf(stderr, "Error writing %s: %s\n", path, strerror(errno));
+        unlink(tmp);
+    }
+    return rc;
+}
+
+// MAPPING
+
+// count elements of elem bytes at off lie inside the image, suitably aligned
+static int inImage(uint64_t off, uint64_t count, size_t elem, size_t size) {
+    return off % IMAGE_ALIGN == 0 && off <= size && count <= (size - off) / elem;
+}
+
+static int namesInImage(const ImageNames *n, size_t size) {
+    return inImage(n->text, n->text_len, 1, size) && n->text_len > 0 &&
+           inImage(n->offset, n->count, sizeof(uint32_t), size) &&
+           inImage(n->length, n->count, sizeof(uint32_t), size) &&
+           inImage(n->hash, n->count, sizeof(uint32_t), size) &&
+           inImage(n->slots, n->slot_count, sizeof(int), size) &&
+           n->slot_count >= 2 && n->slot_count <= INT32_MAX &&
+           (n->slot_count & (n->slot_count - 1)) == 0 && n->count < n->slot_count;
+}
+
+// Past the bounds checks every value that is later used as an index is checked too,
+// in one pass over each array, so a corrupt or foreign image is refused at map time
+// instead of reading out of bounds in every process that maps it.
+
+// every name lies inside the text and ends in its '\0', every slot is empty or an id
+static int namesValid(const ImageNames *n, const char *base) {
+    const char *text = base + n->text;
+    const uint32_t *offset = (const uint32_t *)(base + n->offset);
+    const uint32_t *length = (const uint32_t *)(base + n->length);
+    const int *slots = (const int *)(base + n->slots);
+    for (uint32_t id = 0; id < n->count; id++) {
+        if (length[id] >= n->text_len || offset[id] >= n->text_len - length[id] ||
+            text[offset[id] + length[id]] != '\0') {
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < n->slot_count; i++) {
+        if (slots[i] < 0 || (uint32_t)slots[i] > n->count) return 0;
+    }
+    return 1;
+}
+
+// capacities are positive, routes start at 0, never go back and name known ids
+static int routesValid(const ImageHeader *h, const char *base) {
+    const ScenarioIntersection *intersections = (const ScenarioIntersection *)(base + h->intersections);
+    for (uint32_t i = 0; i < h->intersection_count; i++) {
+        if (intersections[i].capacity < 1) return 0;
+    }
+    const uint32_t *route_offset = (const uint32_t *)(base + h->route_offset);
+    if (route_offset[0] != 0) return 0;
+    for (uint32_t t = 0; t < h->train_count; t++) {
+        if (route_offset[t + 1] < route_offset[t]) return 0;
+    }
+    const int *route_ids = (const int *)(base + h->route_ids);
+    for (uint64_t i = 0; i < h->route_id_count; i++) {
+        if (route_ids[i] < 0 || (uint32_t)route_ids[i] >= h->names.count) return 0;
+    }
+    return 1;
+}
+
+// a NameTable whose arrays are the image's; names_find() works, names_intern() must not be called
+static void namesFromImage(NameTable *t, const char *base, const ImageNames *n) {
+    t->text = (char *)(base + n->text);
+    t->text_len = t->text_cap = n->text_len;
+    t->offset = (uint32_t *)(base + n->offset);
+    t->length = (uint32_t *)(base + n->length);
+    t->hash = (uint32_t *)(base + n->hash);
+    t->count = t->cap = n->count;
+    t->slots = (int *)(base + n->slots);
+    t->slot_mask = n->slot_count - 1;
+}
+
+static int badImage(const char *path, const char *why, void *data, size_t size) {
+    fprintf(stderr, "%s: %s\n", path, why);
+    if (data) munmap(data, size);
+    return -1;
+}
+
+int scenario_map_image(Scenario *sc, const char *path) {
+    memset(sc, 0, sizeof(*sc));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(ImageHeader)) {
+        close(fd);
+        return badImage(path, "not a scenario image (too short)", NULL, 0);
+    }
+    size_t size = st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error mapping %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    const ImageHeader *h = data;
+    const char *base = data;
+    if (memcmp(h->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0) {
+        return badImage(path, "not a scenario image (bad magic)", data, size);
+    }
+    if (h->version != IMAGE_VERSION || h->header_size != sizeof(ImageHeader)) {
+        fprintf(stderr, "%s: image version %u, this build reads version %d; rebuild it with railc\n",
+                path, h->version, IMAGE_VERSION);
+        munmap(data, size);
+        return -1;
+    }
+    if (h->size != size) return badImage(path, "truncated or padded scenario image", data, size);
+    if (!namesInImage(&h->names, size) || !namesInImage(&h->train_names, size) ||
+        h->names.count < h->intersection_count || h->train_names.count != h->train_count ||
+        !inImage(h->intersections, h->intersection_count, sizeof(ScenarioIntersection), size) ||
+        !inImage(h->route_offset, (uint64_t)h->train_count + 1, sizeof(uint32_t), size) ||
+        !inImage(h->route_ids, h->route_id_count, sizeof(int), size) ||
+        !inImage(h->train_line, h->train_count, sizeof(int), size) ||
+        ((const uint32_t *)(base + h->route_offset))[h->train_count] != h->route_id_count) {
+        return badImage(path, "corrupt scenario image (section out of bounds)", data, size);
+    }
+    if (!namesValid(&h->names, base) || !namesValid(&h->train_names, base) || !routesValid(h, base)) {
+        return badImage(path, "corrupt scenario image (name or route out of range)", data, size);
+    }
+
+    // the mapping is read-only, so a stray write faults instead of changing the image
+    namesFromImage(&sc->names, base, &h->names);
+    namesFromImage(&sc->train_names, base, &h->train_names);
+    sc->intersections = (ScenarioIntersection *)(base + h->intersections);
+    sc->intersection_count = h->intersection_count;
+    sc->train_count = h->train_count;
+    sc->route_offset = (uint32_t *)(base + h->route_offset);
+    sc->route_ids = (int *)(base + h->route_ids);
+    sc->train_line = (int *)(base + h->train_line);
+    sc->image = data;
+    sc->image_size = size;
+    return 0;
+}
@@ -0,0 +1,53 @@
+// scenario_image.h
+// Group: B
+// Date: 10-19-2026
+// Compiled scenario images, written by railc. An image is the parsed Scenario laid
+// out in one file: both name tables with their hash indexes, the capacities and the
+// CSR routes. Each section starts on a 64 byte boundary. Loading one is a read-only
+// mmap and a few bounds checks, with no parsing, and every process that maps the
+// same image shares its pages in the page cache.
+//
+// The layout is native endian and tied to IMAGE_VERSION. Any change to the sections
+// or to the structs they hold must bump the version, and a reader refuses any other
+// version.
+#ifndef SCENARIO_IMAGE_H
+#define SCENARIO_IMAGE_H
+
+#include <stdint.h>
+#include "parser.h"
+
+#define IMAGE_MAGIC   "RAILIMG"
+#define IMAGE_VERSION 1
+
+// one NameTable; offsets are from the start of the image
+typedef struct {
+    uint64_t text, offset, length, hash, slots;
+    uint64_t text_len;
+    uint32_t count;
+    uint32_t slot_count;
+} ImageNames;
+
+typedef struct {
+    char magic[8];                  // IMAGE_MAGIC
+    uint32_t version;               // IMAGE_VERSION
+    uint32_t header_size;           // sizeof(ImageHeader)
+    uint64_t size;                  // of the whole file
+    ImageNames names, train_names;
+    uint32_t intersection_count;
+    uint32_t train_count;
+    uint64_t route_id_count;
+    uint64_t intersections;         // ScenarioIntersection[intersection_count]
+    uint64_t route_offset;          // uint32_t[train_count + 1]
+    uint64_t route_ids;             // int[route_id_count]
+    uint64_t train_line;            // int[train_count]
+} ImageHeader;
+
+// writes sc to path through a temporary file and rename(), so processes that have
+// the old image mapped keep a consistent copy. Returns 0 or -1
+int scenario_write_image(const Scenario *sc, const char *path);
+
+// maps path read-only and points sc at it; scenario_free() unmaps it. The scenario
+// must not be parsed into afterwards. Returns 0 or -1 with the reason on stderr
+int scenario_map_image(Scenario *sc, const char *path);
+
+#endif // SCENARIO_IMAGE_H
@@ -0,0 +1,179 @@
+// test_scenario.c
+// Group: B
+// Date: 10-19-2026
+// Checks the mapped scenario parser: interning, tolerated formatting (CRLF, blanks,
+// no final newline), that malformed lines fail with their line number, the
+// compiled image round trip, and that a chunked parse on several threads gives the
+// serial result.
+// Not part of the main build. Compile and run from this directory:
+// gcc -Wall -pthread -o test_scenario test_scenario.c parser.c intern.c arena.c scenario_image.c && ./test_scenario
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "parser.h"
+#include "scenario_image.h"
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static const char *write_file(const char *name, const char *text) {
+    static char path[2][64];
+    static int next = 0;
+    char *p = path[next++ & 1];
+    snprintf(p, sizeof(path[0]), "/tmp/test_scenario_%d_%s", (int)getpid(), name);
+    FILE *f = fopen(p, "w");
+    fputs(text, f);
+    fclose(f);
+    return p;
+}
+
+// parses the two texts, returns scenario_load's result and leaves sc loaded on success
+static int load(Scenario *sc, const char *intersections, const char *trains) {
+    const char *ipath = write_file("intersections.txt", intersections);
+    const char *tpath = write_file("trains.txt", trains);
+    int rc = scenario_load(sc, tpath, ipath);
+    unlink(ipath);
+    unlink(tpath);
+    return rc;
+}
+
+// everything but the memory it lives in
+static int same_scenario(const Scenario *a, const Scenario *b) {
+    if (a->train_count != b->train_count || a->names.count != b->names.count) return 0;
+    for (int id = 0; id < a->names.count; id++) {
+        if (strcmp(scenario_name(a, id), scenario_name(b, id)) != 0) return 0;
+    }
+    for (int t = 0; t < a->train_count; t++) {
+        if (strcmp(scenario_train(a, t).id, scenario_train(b, t).id) != 0) return 0;
+    }
+    return memcmp(a->route_offset, b->route_offset, (a->train_count + 1) * sizeof(uint32_t)) == 0 &&
+           memcmp(a->route_ids, b->route_ids, a->route_offset[a->train_count] * sizeof(int)) == 0 &&
+           memcmp(a->train_line, b->train_line, a->train_count * sizeof(int)) == 0;
+}
+
+int main(void) {
+    Scenario sc;
+
+    // CRLF, padding, a blank line and no newline at the end are all fine
+    check(load(&sc, "A:1\r\n B : 2\n\nC:3",
+               "Train1:A,B,C\r\nTrain2: C , A\nTrain3:D") == 0, "well formed scenario loads");
+    check(sc.intersection_count == 3 && sc.train_count == 3, "counts");
+    check(names_find(&sc.names, "B", 1) == 1 && sc.intersections[1].capacity == 2, "B is id 1 with capacity 2");
+    TrainEntry train2 = scenario_train(&sc, 1);
+    check(train2.routeLength == 2 && train2.route[0] == 2 && train2.route[1] == 0, "Train2 is C,A as ids");
+    check(strcmp(train2.id, "Train2") == 0, "train name");
+    check(scenario_train(&sc, 0).route[2] == train2.route[0], "same name, same id");
+    check(scenario_train(&sc, 2).route[0] == 3 && strcmp(scenario_name(&sc, 3), "D") == 0,
+          "unknown intersection interned after the file's");
+    check(find_intersection_index(&sc, "D") == -1 && find_intersection_index(&sc, "C") == 2, "lookup");
+    check(sc.route_offset[3] == 6, "CSR offsets");
+    check(sc.train_line[2] == 3 && sc.intersections[2].line == 4, "line numbers");
+
+    // a compiled image maps back to the same scenario
+    char image[64];
+    snprintf(image, sizeof(image), "/tmp/test_scenario_%d.img", (int)getpid());
+    Scenario mapped;
+    check(scenario_write_image(&sc, image) == 0 && scenario_map_image(&mapped, image) == 0, "image round trip");
+    check(mapped.train_count == 3 && mapped.intersection_count == 3 && mapped.image != NULL, "image counts");
+    check(find_intersection_index(&mapped, "C") == 2 && mapped.intersections[1].capacity == 2, "image names and capacities");
+    check(memcmp(mapped.route_ids, sc.route_ids, 6 * sizeof(int)) == 0 &&
+          strcmp(scenario_train(&mapped, 1).id, "Train2") == 0, "image routes");
+    scenario_free(&mapped);
+    // a route id past the names, and a name running off the text, are refused at map time
+    ImageHeader h;
+    FILE *f = fopen(image, "r+b");
+    check(f && fread(&h, sizeof(h), 1, f) == 1, "image header");
+    int bad_id = 1000;
+    fseek(f, h.route_ids + sizeof(int), SEEK_SET);
+    fwrite(&bad_id, sizeof(bad_id), 1, f);
+    fflush(f);
+    check(scenario_map_image(&mapped, image) == -1, "route id out of range refused");
+    check(scenario_write_image(&sc, image) == 0, "image rewritten");
+    f = freopen(image, "r+b", f);
+    uint32_t bad_length = 1000;
+    fseek(f, h.names.length, SEEK_SET);
+    fwrite(&bad_length, sizeof(bad_length), 1, f);
+    fclose(f);
+    check(scenario_map_image(&mapped, image) == -1, "name past the text refused");
+    truncate(image, 100);
+    check(scenario_map_image(&mapped, image) == -1, "truncated image refused");
+    unlink(image);
+    scenario_free(&sc);
+
+    // every kind of bad line is refused, not skipped
+    const char *bad_trains[] = {
+        "Train1 A,B",           // no ':'
+        ":A,B",                 // no name
+        "Train1:",              // empty route
+        "Train1:A,,B",          // empty hop
+        "Train1:A,B,",          // trailing comma
+        "Train1:A:B",           // two ':'
+        "Train1:A\nTrain1:B",   // duplicate train
+    };
+    for (size_t i = 0; i < sizeof(bad_trains) / sizeof(bad_trains[0]); i++) {
+        check(load(&sc, "A:1\nB:1", bad_trains[i]) == -1, bad_trains[i]);
+    }
+    const char *bad_intersections[] = { "A", "A:", "A:0", "A:-1", "A:2x", "A:99999999999", "A:1\nA:2", ":1" };
+    for (size_t i = 0; i < sizeof(bad_intersections) / sizeof(bad_intersections[0]); i++) {
+        check(load(&sc, bad_intersections[i], "Train1:A") == -1, bad_intersections[i]);
+    }
+
+    // no fixed limits: a long route with a long name
+    char *route = malloc(200000);
+    strcpy(route, "Train1:");
+    for (int i = 0; i < 10000; i++) strcat(route, i ? ",A" : "AVeryLongIntersectionNameThatDoesNotFitInTheOldSixtyFourCharacterBuffers");
+    check(load(&sc, "A:1", route) == 0 && scenario_route_length(&sc, 0) == 10000, "10000 hop route");
+    scenario_free(&sc);
+    free(route);
+
+    // trains added one line at a time, past the first growth of the arrays
+    scenario_init(&sc);
+    int added = 0;
+    for (int i = 0; i < 200; i++) {
+        char line[64];
+        int len = snprintf(line, sizeof(line), "Train%d:A,B%d", i, i % 7);
+        if (scenario_add_train(&sc, line, len, "stream", i + 1) == i) added++;
+    }
+    check(added == 200 && sc.route_offset[200] == 400, "scenario_add_train grows");
+    check(strcmp(scenario_name(&sc, scenario_train(&sc, 199).route[1]), "B3") == 0, "added route");
+    check(scenario_add_train(&sc, "Train5:A", 8, "stream", 201) == -1 && sc.train_count == 200, "added duplicate refused");
+    scenario_free(&sc);
+
+    // chunks on any number of threads: same ids, same trains, same line numbers, with
+    // duplicates and bad lines spread across chunk boundaries
+    size_t cap = 1 << 20, len = 0;
+    char *text = malloc(cap);
+    for (int i = 0; i < 5000; i++) {
+        if (i % 97 == 0) len += snprintf(text + len, cap - len, "broken line %d\n", i);
+        else if (i % 211 == 0) len += snprintf(text + len, cap - len, "Train%d:A\n", i / 3);
+        else if (i % 13 == 0) len += snprintf(text + len, cap - len, "\n");
+        else len += snprintf(text + len, cap - len, "Train%d:X%d,A,Y%d\n", i, i % 301, i % 17);
+    }
+    const char *ipath = write_file("intersections.txt", "A:1\nB:2");
+    const char *tpath = write_file("trains.txt", text);
+    Scenario serial, chunked;
+    scenario_init(&serial);
+    scenario_parse_intersections(&serial, ipath);
+    check(scenario_parse_trains_threads(&serial, tpath, 1) == -1 && serial.train_count > 4000, "serial parse");
+    for (int threads = 2; threads <= 7; threads += 5) {
+        scenario_init(&chunked);
+        scenario_parse_intersections(&chunked, ipath);
+        check(scenario_parse_trains_threads(&chunked, tpath, threads) == -1, "chunked parse reports the bad lines");
+        check(same_scenario(&serial, &chunked), "chunked parse matches the serial one");
+        scenario_free(&chunked);
+    }
+    scenario_free(&serial);
+    unlink(ipath);
+    unlink(tpath);
+    free(text);
+
+    printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
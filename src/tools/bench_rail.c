@@ -0,0 +1,348 @@
+// bench_rail.c
+// Group: B
+// Date: 10-19-2026
+// End-to-end throughput benchmark. Starts the real server (iLikeTrains) in a scratch
+// directory with generated intersections, forks N synthetic trains that ACQUIRE and
+// RELEASE random intersections back to back with no traversal delay, and after the
+// run prints one JSON object: requests/sec, round-trip latency percentiles as the
+// trains saw them, the server's own service time, and CPU time per request.
+// Nothing is measured during the warmup; CPU per request uses every request of the run.
+//
+// usage: ./bench_rail [-t trains] [-n intersections] [-k cap[,cap...]] [-d seconds]
+//                     [-w warmup] [-T transport] [-l log_level] [-s server] [-o out.json]
+//   -t  trains, 1..MAX_TRAINS (default 4)
+//   -n  intersections, 1..NUM_INTERSECTIONS (default 3)
+//   -k  capacities, one per intersection; the last one repeats (default 1)
+//   -d  measured seconds (default 5), -w warmup seconds before that (default 1)
+//   -T  transport, only "msgq" (System V message queue) exists today
+//   -l  RAIL_LOG_LEVEL for the server, e.g. WARN to leave logging out of the numbers
+//   -s  server binary (default ./iLikeTrains), -o JSON file (default stdout)
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE   // MAP_ANONYMOUS, wait4
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/msg.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "../Basic_IPC_Workflow/ipc.h"
+
+#define SERVER_START_MS 5000
+
+// shared with the train processes (anonymous MAP_SHARED)
+typedef struct {
+    uint64_t measured;              // requests answered inside the measured window
+    uint64_t total;                 // every request, warmup included
+    int failures;                   // replies that were neither GRANT/WAIT nor OK
+    LatencyHistogram acquire;       // ACQUIRE sent -> GRANT received, waits included
+    LatencyHistogram release;       // RELEASE sent -> OK received
+} BenchShared;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static double tv_us(struct timeval tv) {
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// waits for the reply to this train; WAIT is skipped since GRANT follows it
+static int await_reply(int msgid, int train_id, const char *want) {
+    Message reply;
+    while (1) {
+        if (msgrcv(msgid, &reply, sizeof(reply) - sizeof(long), train_id + 100, 0) == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (strcmp(reply.action, "WAIT") == 0) continue;
+        return strcmp(reply.action, want) == 0 ? 0 : -1;
+    }
+}
+
+static void run_train(int msgid, int train_id, int intersections, uint64_t measure_from,
+                      uint64_t stop_at, BenchShared *shared) {
+    unsigned int seed = (unsigned int)train_id * 2654435761u;
+    char name[MAX_NAME];
+    while (1) {
+        uint64_t start = mono_ns();
+        if (start >= stop_at) break;
+        int measured = start >= measure_from;
+        snprintf(name, sizeof(name), "Intersection%c", 'A' + rand_r(&seed) % intersections);
+
+        send_message(msgid, train_id, name, "ACQUIRE");
+        if (await_reply(msgid, train_id, "GRANT") != 0) {
+            __atomic_fetch_add(&shared->failures, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        uint64_t granted = mono_ns();
+
+        send_message(msgid, train_id, name, "RELEASE");
+        if (await_reply(msgid, train_id, "OK") != 0) {
+            __atomic_fetch_add(&shared->failures, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        uint64_t released = mono_ns();
+
+        __atomic_fetch_add(&shared->total, 2, __ATOMIC_RELAXED);
+        if (measured && released <= stop_at) {
+            hist_record(&shared->acquire, granted - start);
+            hist_record(&shared->release, released - granted);
+            __atomic_fetch_add(&shared->measured, 2, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// text_files/ in the scratch directory, read by the server's parser
+static int write_inputs(const char *dir, int trains, int intersections, const int capacity[]) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/text_files", dir);
+    if (mkdir(path, 0755) == -1) {
+        perror("bench_rail: mkdir text_files");
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/text_files/intersections.txt", dir);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("bench_rail: intersections.txt");
+        return -1;
+    }
+    for (int i = 0; i < intersections; i++) fprintf(f, "Intersection%c:%d\n", 'A' + i, capacity[i]);
+    fclose(f);
+
+    // the server only prints the routes, the synthetic trains pick their own
+    snprintf(path, sizeof(path), "%s/text_files/trains.txt", dir);
+    f = fopen(path, "w");
+    if (!f) {
+        perror("bench_rail: trains.txt");
+        return -1;
+    }
+    for (int t = 1; t <= trains; t++) {
+        fprintf(f, "Train%d:", t);
+        for (int i = 0; i < intersections; i++) fprintf(f, "%sIntersection%c", i ? "," : "", 'A' + i);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+static void print_hist(FILE *out, const char *name, const LatencyHistogram *h, int last) {
+    uint64_t count = h->count;
+    fprintf(out, "    \"%s\": {\"count\": %llu, \"mean\": %llu, \"p50\": %llu, \"p90\": %llu, "
+            "\"p99\": %llu, \"p999\": %llu, \"max\": %llu}%s\n", name,
+            (unsigned long long)count, (unsigned long long)(count ? h->sum_ns / count : 0),
+            (unsigned long long)stats_percentile(h, 0.50), (unsigned long long)stats_percentile(h, 0.90),
+            (unsigned long long)stats_percentile(h, 0.99), (unsigned long long)stats_percentile(h, 0.999),
+            (unsigned long long)h->max_ns, last ? "" : ",");
+}
+
+int main(int argc, char *argv[]) {
+    int trains = 4, intersections = 3;
+    int capacity[NUM_INTERSECTIONS];
+    int cap_given = 0;
+    double duration = 5.0, warmup = 1.0;
+    const char *transport = "msgq";
+    const char *log_level = NULL;
+    const char *server = "./iLikeTrains";
+    const char *out_path = NULL;
+
+    for (int i = 0; i < NUM_INTERSECTIONS; i++) capacity[i] = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:k:d:w:T:l:s:o:")) != -1) {
+        switch (opt) {
+        case 't': trains = atoi(optarg); break;
+        case 'n': intersections = atoi(optarg); break;
+        case 'k': {
+            char *list = strdup(optarg);
+            cap_given = 0;
+            for (char *tok = strtok(list, ","); tok && cap_given < NUM_INTERSECTIONS; tok = strtok(NULL, ",")) {
+                capacity[cap_given++] = atoi(tok);
+            }
+            free(list);
+            break;
+        }
+        case 'd': duration = atof(optarg); break;
+        case 'w': warmup = atof(optarg); break;
+        case 'T': transport = optarg; break;
+        case 'l': log_level = optarg; break;
+        case 's': server = optarg; break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-t trains] [-n intersections] [-k cap[,cap...]] [-d seconds] "
+                    "[-w warmup] [-T msgq] [-l log_level] [-s server] [-o out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (int i = cap_given; cap_given > 0 && i < NUM_INTERSECTIONS; i++) capacity[i] = capacity[cap_given - 1];
+
+    if (trains < 1 || trains > MAX_TRAINS || intersections < 1 || intersections > NUM_INTERSECTIONS) {
+        fprintf(stderr, "bench_rail: need 1..%d trains and 1..%d intersections\n", MAX_TRAINS, NUM_INTERSECTIONS);
+        return 1;
+    }
+    for (int i = 0; i < intersections; i++) {
+        if (capacity[i] < 1 || capacity[i] > MAX_TRAINS) {
+            fprintf(stderr, "bench_rail: capacity must be 1..%d\n", MAX_TRAINS);
+            return 1;
+        }
+    }
+    if (strcmp(transport, "msgq") != 0) {
+        fprintf(stderr, "bench_rail: unknown transport %s (available: msgq)\n", transport);
+        return 1;
+    }
+    if (duration <= 0 || warmup < 0) {
+        fprintf(stderr, "bench_rail: bad duration or warmup\n");
+        return 1;
+    }
+    if (msgget(MSG_KEY, 0) != -1) {
+        fprintf(stderr, "bench_rail: message queue %d exists, is a simulation running?\n", MSG_KEY);
+        return 1;
+    }
+
+    char server_path[PATH_MAX];
+    if (!realpath(server, server_path)) {
+        perror("bench_rail: server binary");
+        return 1;
+    }
+    char workdir[] = "/tmp/bench_rail.XXXXXX";
+    if (!mkdtemp(workdir)) {
+        perror("bench_rail: mkdtemp");
+        return 1;
+    }
+    if (write_inputs(workdir, trains, intersections, capacity) != 0) {
+        nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+        return 1;
+    }
+
+    BenchShared *shared = mmap(NULL, sizeof(BenchShared), PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("bench_rail: mmap");
+        return 1;
+    }
+    memset(shared, 0, sizeof(*shared));
+
+    // server, with its logs kept out of the way in the scratch directory
+    pid_t server_pid = fork();
+    if (server_pid == 0) {
+        if (chdir(workdir) == -1) _exit(127);
+        FILE *sink = freopen("server.out", "w", stdout);
+        if (sink) dup2(fileno(stdout), STDERR_FILENO);
+        if (log_level) setenv("RAIL_LOG_LEVEL", log_level, 1);
+        execl(server_path, server_path, (char *)NULL);
+        _exit(127);
+    }
+    if (server_pid < 0) {
+        perror("bench_rail: fork server");
+        return 1;
+    }
+
+    int msgid = -1;
+    for (int waited = 0; waited < SERVER_START_MS && msgid == -1; waited += 10) {
+        struct timespec pause = { 0, 10000000L };
+        nanosleep(&pause, NULL);
+        msgid = msgget(MSG_KEY, 0);
+    }
+    if (msgid == -1) {
+        fprintf(stderr, "bench_rail: server did not create the message queue\n");
+        kill(server_pid, SIGTERM);
+        waitpid(server_pid, NULL, 0);
+        nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+        return 1;
+    }
+
+    uint64_t start = mono_ns();
+    uint64_t measure_from = start + (uint64_t)(warmup * 1e9);
+    uint64_t stop_at = measure_from + (uint64_t)(duration * 1e9);
+    pid_t train_pids[MAX_TRAINS];
+    int started = 0;
+    for (int t = 1; t <= trains; t++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run_train(msgid, t, intersections, measure_from, stop_at, shared);
+            _exit(0);
+        }
+        if (pid < 0) perror("bench_rail: fork train");
+        else train_pids[started++] = pid;
+    }
+    for (int i = 0; i < started; i++) waitpid(train_pids[i], NULL, 0);
+
+    // the server's own histograms and request counter, before STOP removes them
+    LatencyHistogram service;
+    memset(&service, 0, sizeof(service));
+    uint64_t server_requests = 0;
+    size_t shm_size;
+    SharedIntersection *shm = attach_shared_memory("/intersection_shm", &shm_size);
+    if (shm) {
+        const RailStats *stats = shm_stats(shm);
+        server_requests = stats->counters[STAT_REQUESTS];
+        for (int i = 0; i < intersections; i++) {
+            const LatencyHistogram *h = &stats->hist[i][STAT_SERVICE];
+            service.count += h->count;
+            service.sum_ns += h->sum_ns;
+            if (h->max_ns > service.max_ns) service.max_ns = h->max_ns;
+            for (int b = 0; b < STATS_BUCKETS; b++) service.buckets[b] += h->buckets[b];
+        }
+        munmap(shm, shm_size);
+    }
+
+    struct rusage train_usage;
+    getrusage(RUSAGE_CHILDREN, &train_usage);
+
+    Message stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.mtype = 1;
+    snprintf(stop.intersection, sizeof(stop.intersection), "SYSTEM");
+    snprintf(stop.action, sizeof(stop.action), "STOP");
+    if (msgsnd(msgid, &stop, sizeof(stop) - sizeof(long), 0) == -1) perror("bench_rail: STOP");
+
+    int status = 0;
+    struct rusage server_usage;
+    memset(&server_usage, 0, sizeof(server_usage));
+    if (wait4(server_pid, &status, 0, &server_usage) == -1) perror("bench_rail: wait server");
+    nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+
+    uint64_t total = shared->total ? shared->total : 1;
+    double server_cpu = tv_us(server_usage.ru_utime) + tv_us(server_usage.ru_stime);
+    double train_cpu = tv_us(train_usage.ru_utime) + tv_us(train_usage.ru_stime);
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror("bench_rail: output");
+        out = stdout;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"bench_rail\",\n  \"params\": {\"trains\": %d, \"intersections\": %d, "
+            "\"capacities\": [", trains, intersections);
+    for (int i = 0; i < intersections; i++) fprintf(out, "%s%d", i ? ", " : "", capacity[i]);
+    fprintf(out, "], \"duration_s\": %.3f, \"warmup_s\": %.3f, \"transport\": \"%s\", \"log_level\": \"%s\"},\n",
+            duration, warmup, transport, log_level ? log_level : "default");
+    fprintf(out, "  \"requests\": %llu,\n  \"requests_per_sec\": %.1f,\n  \"failures\": %d,\n",
+            (unsigned long long)shared->measured, shared->measured / duration, shared->failures);
+    fprintf(out, "  \"latency_ns\": {\n");
+    print_hist(out, "acquire", &shared->acquire, 0);
+    print_hist(out, "release", &shared->release, 0);
+    print_hist(out, "server_service", &service, 1);
+    fprintf(out, "  },\n  \"cpu_us_per_request\": {\"server\": %.2f, \"trains\": %.2f},\n",
+            server_cpu / (server_requests ? server_requests : total), train_cpu / total);
+    fprintf(out, "  \"server_exit\": %d\n}\n", WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    if (out != stdout) fclose(out);
+
+    return shared->failures || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
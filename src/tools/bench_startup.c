@@ -0,0 +1,220 @@
+// bench_startup.c
+// Group: B
+// Date: 10-19-2026
+// Scenario load time, the part of server and train_sim startup that grows with the
+// trains file. For each size it generates a trains file of that many lines in a
+// scratch directory and times, best of the repeats: the serial parse, the chunked
+// parse on -j threads, and mapping the same scenario compiled to an image (railc).
+// It also checks that the chunked parse gave the serial result, then prints one
+// JSON object.
+//
+// usage: ./bench_startup [-n lines[,lines...]] [-j threads] [-r repeats] [-o out.json]
+//   -n  trains file sizes in lines (default 1000000,10000000)
+//   -j  threads for the chunked parse (default one per CPU)
+//   -r  repeats of each measurement, the best one counts (default 3)
+//   -o  JSON file (default stdout)
+#define _XOPEN_SOURCE 700
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../parser/parser.h"
+#include "../parser/scenario_image.h"
+
+#define MAX_SIZES 8
+#define INTERSECTIONS 5
+
+typedef struct {
+    long lines;
+    long long bytes;
+    long long hops;
+    double serial_ms, chunked_ms, image_ms;
+    int identical;
+} StartupRun;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+// routes of 3 to 8 hops over the five intersections, like text_files/trains.txt
+static long long write_trains(const char *path, long lines) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("bench_startup: trains.txt");
+        return -1;
+    }
+    unsigned int seed = 42;
+    for (long t = 1; t <= lines; t++) {
+        fprintf(f, "Train%ld:", t);
+        int hops = 3 + rand_r(&seed) % 6;
+        for (int i = 0; i < hops; i++) fprintf(f, "%sIntersection%c", i ? "," : "", 'A' + rand_r(&seed) % INTERSECTIONS);
+        fputc('\n', f);
+    }
+    long long bytes = ftell(f);
+    if (fclose(f) == EOF) return -1;
+    return bytes;
+}
+
+// what getScenario() does, with the trains file parsed on the given number of threads
+static int load(Scenario *sc, const char *trains, const char *intersections, int threads) {
+    if (scenario_init(sc) == -1) return -1;
+    if (scenario_parse_intersections(sc, intersections) == -1 ||
+        scenario_parse_trains_threads(sc, trains, threads) == -1) {
+        scenario_free(sc);
+        return -1;
+    }
+    return 0;
+}
+
+static int same_scenario(const Scenario *a, const Scenario *b) {
+    if (a->train_count != b->train_count || a->names.count != b->names.count ||
+        a->train_names.text_len != b->train_names.text_len) {
+        return 0;
+    }
+    return memcmp(a->names.text, b->names.text, a->names.text_len) == 0 &&
+           memcmp(a->train_names.text, b->train_names.text, a->train_names.text_len) == 0 &&
+           memcmp(a->route_offset, b->route_offset, (a->train_count + 1) * sizeof(uint32_t)) == 0 &&
+           memcmp(a->route_ids, b->route_ids, a->route_offset[a->train_count] * sizeof(int)) == 0 &&
+           memcmp(a->train_line, b->train_line, a->train_count * sizeof(int)) == 0;
+}
+
+static int run_size(const char *dir, long lines, int threads, int repeats, StartupRun *run) {
+    char trains[4096], intersections[4096], image[4096];
+    snprintf(trains, sizeof(trains), "%s/trains.txt", dir);
+    snprintf(intersections, sizeof(intersections), "%s/intersections.txt", dir);
+    snprintf(image, sizeof(image), "%s/scenario.img", dir);
+    memset(run, 0, sizeof(*run));
+    run->lines = lines;
+    if ((run->bytes = write_trains(trains, lines)) < 0) return -1;
+
+    Scenario serial, chunked, mapped;
+    for (int r = 0; r < repeats; r++) {
+        double start = now_ms();
+        if (load(&serial, trains, intersections, 1) == -1) return -1;
+        double ms = now_ms() - start;
+        if (r == 0 || ms < run->serial_ms) run->serial_ms = ms;
+        if (r < repeats - 1) scenario_free(&serial);
+    }
+    run->hops = serial.route_offset[serial.train_count];
+
+    for (int r = 0; r < repeats; r++) {
+        double start = now_ms();
+        if (load(&chunked, trains, intersections, threads) == -1) return -1;
+        double ms = now_ms() - start;
+        if (r == 0 || ms < run->chunked_ms) run->chunked_ms = ms;
+        if (r == 0) run->identical = same_scenario(&serial, &chunked);
+        scenario_free(&chunked);
+    }
+
+    int rc = scenario_write_image(&serial, image);
+    scenario_free(&serial);
+    if (rc == -1) return -1;
+    for (int r = 0; r < repeats; r++) {
+        double start = now_ms();
+        if (scenario_map_image(&mapped, image) == -1) return -1;
+        double ms = now_ms() - start;
+        if (r == 0 || ms < run->image_ms) run->image_ms = ms;
+        scenario_free(&mapped);
+    }
+    unlink(image);
+    unlink(trains);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long sizes[MAX_SIZES] = { 1000000, 10000000 };
+    int size_count = 2;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    int repeats = 3;
+    const char *out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:r:o:")) != -1) {
+        switch (opt) {
+        case 'n': {
+            size_count = 0;
+            char *p = optarg;
+            while (*p && size_count < MAX_SIZES) {
+                sizes[size_count++] = strtol(p, &p, 10);
+                if (*p == ',') p++;
+            }
+            break;
+        }
+        case 'j': threads = atoi(optarg); break;
+        case 'r': repeats = atoi(optarg); break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-n lines[,lines...]] [-j threads] [-r repeats] [-o out.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (int i = 0; i < size_count; i++) {
+        if (sizes[i] < 1) {
+            fprintf(stderr, "bench_startup: sizes must be at least 1 line\n");
+            return 1;
+        }
+    }
+    if (threads < 1 || repeats < 1) {
+        fprintf(stderr, "bench_startup: threads and repeats must be at least 1\n");
+        return 1;
+    }
+
+    char workdir[] = "/tmp/bench_startup.XXXXXX";
+    if (!mkdtemp(workdir)) {
+        perror("bench_startup: mkdtemp");
+        return 1;
+    }
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/intersections.txt", workdir);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("bench_startup: intersections.txt");
+        nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+        return 1;
+    }
+    for (int i = 0; i < INTERSECTIONS; i++) fprintf(f, "Intersection%c:%d\n", 'A' + i, 1 + i % 3);
+    fclose(f);
+
+    StartupRun runs[MAX_SIZES];
+    int rc = 0;
+    for (int i = 0; i < size_count && rc == 0; i++) {
+        fprintf(stderr, "bench_startup: %ld lines\n", sizes[i]);
+        rc = run_size(workdir, sizes[i], threads, repeats, &runs[i]);
+    }
+    nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+    if (rc == -1) {
+        fprintf(stderr, "bench_startup: run failed\n");
+        return 1;
+    }
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror("bench_startup: output");
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"bench_startup\",\n  \"params\": {\"threads\": %d, \"cpus\": %ld, \"repeats\": %d},\n",
+            threads, cpus, repeats);
+    fprintf(out, "  \"runs\": [\n");
+    for (int i = 0; i < size_count; i++) {
+        StartupRun *r = &runs[i];
+        fprintf(out, "    {\"lines\": %ld, \"bytes\": %lld, \"hops\": %lld, \"serial_ms\": %.1f, \"chunked_ms\": %.1f, "
+                "\"speedup\": %.2f, \"image_ms\": %.3f, \"identical\": %s}%s\n",
+                r->lines, r->bytes, r->hops, r->serial_ms, r->chunked_ms, r->serial_ms / r->chunked_ms,
+                r->image_ms, r->identical ? "true" : "false", i < size_count - 1 ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    if (out != stdout) fclose(out);
+    for (int i = 0; i < size_count; i++) {
+        if (!runs[i].identical) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+// microbench.c
+// Group: B
+// Date: 10-19-2026
+// Timings for the core operations, each in isolation and single threaded:
+// shared-memory holder and waiter tracking, intersection lookup, deadlock detection
+// as the graph grows, the sim clock, log_event and LOG_CSV_impl.
+// The process is pinned to one CPU. Each benchmark picks a batch size so a sample
+// takes ~200 us, throws away the warmup samples, and reports min, median and p99
+// of ns per operation over the rest. With -o the results are saved as JSON, one
+// benchmark per line; -b compares a run against such a file.
+//
+// Runs on a private copy of the intersections and in a scratch directory, so it
+// never touches /intersection_shm, but refuses to start while a simulation is running
+// because log_event would join its shared log rings.
+//
+// usage: ./microbench [-r samples] [-w warmup] [-c cpu] [-f filter] [-o out.json] [-b baseline.json]
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/msg.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "../Basic_IPC_Workflow/ipc.h"
+#include "../Basic_IPC_Workflow/fake_sec.h"
+#include "../Basic_IPC_Workflow/resource_allocation_graph.h"
+#include "../parser/parser.h"
+#include "../logger/logger.h"
+#include "../logger/csv_logger.h"
+
+#define SAMPLE_TARGET_NS 200000
+#define MAX_SAMPLES      1000
+#define MAX_RESULTS      64
+
+typedef struct {
+    char name[64];
+    double min_ns, median_ns, p99_ns;
+} Result;
+
+static Result results[MAX_RESULTS];
+static int result_count = 0;
+static int samples = 51, warmup = 5;
+static const char *filter = NULL;
+
+static SharedIntersection *intersections;   // full segment size, the lock wrapper needs the stats region
+static Scenario scenario;          // only the intersection names, for find_intersection_index
+static TrainEntry train;
+static int graph_trains;            // size of the graph detect_deadlock walks
+static volatile int sink;           // keeps results alive so calls are not optimized out
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// runs op() batch times per sample and records the ns/op distribution under name
+static void run(const char *name, void (*op)(long i)) {
+    if (filter && !strstr(name, filter)) return;
+    if (result_count == MAX_RESULTS) return;
+
+    // batch size: double until one sample takes long enough to time accurately
+    long batch = 1;
+    for (;;) {
+        uint64_t start = mono_ns();
+        for (long i = 0; i < batch; i++) op(i);
+        if (mono_ns() - start >= SAMPLE_TARGET_NS || batch >= (1L << 24)) break;
+        batch *= 2;
+    }
+
+    static double ns[MAX_SAMPLES];
+    long next = 0;
+    for (int s = 0; s < warmup + samples; s++) {
+        uint64_t start = mono_ns();
+        for (long i = 0; i < batch; i++) op(next++);
+        uint64_t elapsed = mono_ns() - start;
+        if (s >= warmup) ns[s - warmup] = (double)elapsed / batch;
+    }
+    qsort(ns, samples, sizeof(double), cmp_double);
+
+    Result *r = &results[result_count++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->min_ns = ns[0];
+    r->median_ns = ns[samples / 2];
+    int p99 = (int)(samples * 0.99);
+    r->p99_ns = ns[p99 < samples ? p99 : samples - 1];
+}
+
+// ---- operations under test, one call (or one matched pair) per invocation ----
+
+static void op_holder_pair(long i) {
+    sink = add_holder(intersections, 1, (int)(i & 7) + 1);
+    remove_holder(intersections, 1, (int)(i & 7) + 1);
+}
+
+static void op_holder_pair_profiled(long i) {
+    shm_stats(intersections)->lock_profiling = 1;
+    op_holder_pair(i);
+    shm_stats(intersections)->lock_profiling = 0;
+}
+
+static void op_waiter_pair(long i) {
+    enqueue_waiter(intersections, 2, (int)(i & 7) + 1);
+    sink = dequeue_waiter(intersections, 2);
+}
+
+static void op_find_index(long i) {
+    static const char *names[] = { "IntersectionA", "IntersectionB", "IntersectionC",
+                                   "IntersectionD", "IntersectionE", "IntersectionX" };
+    sink = find_intersection_index(&scenario, names[i % 6]);
+}
+
+static void op_detect_deadlock(long i) {
+    (void)i;
+    sink = detect_deadlock();
+}
+
+static void op_set_fake_sec(long i) {
+    (void)i;
+    setFakeSec(1);
+}
+
+static void op_get_fake_time(long i) {
+    (void)i;
+    sink = getFakeTime()[1];
+}
+
+static void op_log_event(long i) {
+    log_event("[00:00:00] SERVER", "GRANTED %s to Train %d", "IntersectionB", (int)(i & 7) + 1);
+}
+
+static void op_log_csv(long i) {
+    sink = LOG_CSV((int)(i & 7) + 1, "IntersectionB", "ACQUIRE", "GRANT", 4242, NULL,
+                   &intersections[1], &train, (int)(i % 3), false, 0, NULL, NULL);
+}
+
+// train t holds intersection t and waits for t+1; the last one closes the cycle or not
+static void build_chain(int trains, int cycle) {
+    char name[2] = { 0, 0 };
+    init_graph();
+    for (int t = 0; t < trains; t++) {
+        name[0] = 'A' + t;
+        add_request_edge(t + 1, name);
+        add_allocation_edge(t + 1, name);
+    }
+    for (int t = 0; t < trains - 1 + cycle; t++) {
+        name[0] = 'A' + (t + 1) % trains;
+        add_request_edge(t + 1, name);
+    }
+    graph_trains = trains;
+}
+
+static int setup_intersections(void) {
+    intersections = aligned_alloc(64, (SHM_SEGMENT_SIZE + 63) & ~(size_t)63);
+    if (!intersections) return -1;
+    memset(intersections, 0, SHM_SEGMENT_SIZE);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED); // same mutexes as the real segment
+    for (int i = 0; i < NUM_INTERSECTIONS; i++) {
+        pthread_mutex_init(&intersections[i].mutex, &attr);
+        intersections[i].capacity = 3;
+        snprintf(intersections[i].semName, sizeof(intersections[i].semName), "/sem_intersection_%d", i);
+    }
+    pthread_mutexattr_destroy(&attr);
+    if (scenario_init(&scenario) == -1) return -1;
+    for (int i = 0; i < NUM_INTERSECTIONS; i++) {
+        char name[16];
+        int len = snprintf(name, sizeof(name), "Intersection%c", 'A' + i);
+        if (names_intern(&scenario.names, name, len) == -1) return -1;
+    }
+    scenario.intersection_count = NUM_INTERSECTIONS;
+    // a realistic amount of state: one other holder and one other waiter
+    add_holder(intersections, 1, 9);
+    enqueue_waiter(intersections, 2, 9);
+    shared_intersections = intersections; // the clock and the loggers read it from here
+    train.routeLength = 3;
+    return 0;
+}
+
+// median_ns of name in a file written with -o, or -1
+static double baseline_median(const char *path, const char *name) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char line[512], found[64];
+    double median = -1, value;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"min_ns\": %*f, \"median_ns\": %lf", found, &value) == 2 &&
+            strcmp(found, name) == 0) {
+            median = value;
+            break;
+        }
+    }
+    fclose(f);
+    return median;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+int main(int argc, char *argv[]) {
+    int cpu = -1;
+    const char *out_path = NULL, *baseline = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:w:c:f:o:b:")) != -1) {
+        switch (opt) {
+        case 'r': samples = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 'f': filter = optarg; break;
+        case 'o': out_path = optarg; break;
+        case 'b': baseline = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-r samples] [-w warmup] [-c cpu] [-f filter] "
+                    "[-o out.json] [-b baseline.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (samples < 1 || samples > MAX_SAMPLES || warmup < 0 || warmup + samples > MAX_SAMPLES) {
+        fprintf(stderr, "microbench: samples must be 1..%d including warmup\n", MAX_SAMPLES);
+        return 1;
+    }
+    if (msgget(MSG_KEY, 0) != -1) {
+        fprintf(stderr, "microbench: message queue %d exists, is a simulation running?\n", MSG_KEY);
+        return 1;
+    }
+
+    // one CPU for the whole run, the one we started on unless -c says otherwise
+    if (cpu < 0) cpu = sched_getcpu();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+        perror("microbench: sched_setaffinity");
+        cpu = -1;
+    }
+
+    // log and CSV files go to a scratch directory that is removed at the end
+    char workdir[] = "/tmp/microbench.XXXXXX";
+    char origin[4096];
+    if (!getcwd(origin, sizeof(origin)) || !mkdtemp(workdir) || chdir(workdir) == -1) {
+        perror("microbench: scratch directory");
+        return 1;
+    }
+
+    if (setup_intersections() != 0) {
+        perror("microbench: segment");
+        return 1;
+    }
+    log_init("microbench.log", 0);
+    if (!csv_logger_init()) {
+        perror("microbench: csv_logger_init");
+        return 1;
+    }
+
+    run("holder/add+remove", op_holder_pair);
+    run("holder/add+remove profiled", op_holder_pair_profiled);
+    run("waiter/enqueue+dequeue", op_waiter_pair);
+    run("find_intersection_index", op_find_index);
+    char name[64];
+    for (int trains = 2; trains <= MAX_TRAINS; trains += 2) {
+        build_chain(trains, 0);
+        snprintf(name, sizeof(name), "detect_deadlock/chain_%d", graph_trains);
+        run(name, op_detect_deadlock);
+        build_chain(trains, 1);
+        snprintf(name, sizeof(name), "detect_deadlock/cycle_%d", graph_trains);
+        run(name, op_detect_deadlock);
+    }
+    run("clock/setFakeSec", op_set_fake_sec);
+    run("clock/getFakeTime", op_get_fake_time);
+    run("log_event", op_log_event);
+    run("LOG_CSV_impl", op_log_csv);
+
+    csv_logger_close();
+    if (chdir(origin) == -1) perror("microbench: chdir");
+    nftw(workdir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+
+    printf("cpu %d, %d samples after %d warmup, ns per operation\n", cpu, samples, warmup);
+    printf("%-28s %10s %10s %10s%s\n", "benchmark", "min", "median", "p99", baseline ? "   vs base" : "");
+    for (int i = 0; i < result_count; i++) {
+        Result *r = &results[i];
+        printf("%-28s %10.1f %10.1f %10.1f", r->name, r->min_ns, r->median_ns, r->p99_ns);
+        double base = baseline ? baseline_median(baseline, r->name) : -1;
+        if (base > 0) printf("   %+7.1f%%", (r->median_ns - base) / base * 100);
+        printf("\n");
+    }
+
+    if (out_path) {
+        FILE *out = fopen(out_path, "w");
+        if (!out) {
+            perror("microbench: output");
+            return 1;
+        }
+        fprintf(out, "{\"benchmark\": \"microbench\", \"cpu\": %d, \"samples\": %d, \"warmup\": %d, \"results\": [\n",
+                cpu, samples, warmup);
+        for (int i = 0; i < result_count; i++) {
+            fprintf(out, "  {\"name\": \"%s\", \"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f}%s\n",
+                    results[i].name, results[i].min_ns, results[i].median_ns, results[i].p99_ns,
+                    i + 1 < result_count ? "," : "");
+        }
+        fprintf(out, "]}\n");
+        fclose(out);
+    }
+    return 0;
+}
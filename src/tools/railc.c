@@ -0,0 +1,72 @@
+// railc.c
+// Group: B
+// Date: 10-19-2026
+// Scenario compiler. Parses trains.txt and intersections.txt once and writes the
+// result as a binary image (scenario_image.h) that iLikeTrains and train_sim map
+// instead of parsing, when started with RAIL_SCENARIO pointing at it:
+//
+//   ./railc -o scenario.img
+//   RAIL_SCENARIO=scenario.img ./iLikeTrains
+//   RAIL_SCENARIO=scenario.img ./train_sim
+//
+// usage: ./railc [-t trains.txt] [-i intersections.txt] [-o out.img]
+//        ./railc -c image       map an existing image and print what it holds
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../parser/parser.h"
+#include "../parser/scenario_image.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void print_summary(const Scenario *sc) {
+    printf("%d intersections, %d trains, %u hops, %d distinct names\n", sc->intersection_count,
+           sc->train_count, sc->route_offset[sc->train_count], sc->names.count);
+}
+
+int main(int argc, char *argv[]) {
+    const char *trains = TRAINS_FILE, *intersections = INTERSECTIONS_FILE;
+    const char *out = "scenario.img", *check = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:i:o:c:")) != -1) {
+        switch (opt) {
+        case 't': trains = optarg; break;
+        case 'i': intersections = optarg; break;
+        case 'o': out = optarg; break;
+        case 'c': check = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-t trains.txt] [-i intersections.txt] [-o out.img] | -c image\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Scenario sc;
+    if (check) {
+        double start = now_ms();
+        if (scenario_map_image(&sc, check) == -1) return 1;
+        double mapped = now_ms();
+        printf("%s: %zu bytes, mapped in %.3f ms\n", check, sc.image_size, mapped - start);
+        print_summary(&sc);
+        scenario_free(&sc);
+        return 0;
+    }
+
+    double start = now_ms();
+    if (scenario_load(&sc, trains, intersections) == -1) return 1;
+    double parsed = now_ms();
+    if (scenario_write_image(&sc, out) == -1) {
+        scenario_free(&sc);
+        return 1;
+    }
+    double written = now_ms();
+    printf("%s: parsed %s and %s in %.1f ms, wrote the image in %.1f ms\n", out, trains, intersections,
+           parsed - start, written - parsed);
+    print_summary(&sc);
+    scenario_free(&sc);
+    return 0;
+}
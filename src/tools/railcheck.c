@@ -0,0 +1,330 @@
+// railcheck.c
+// Group: B
+// Date: 10-19-2026
+// Static check of a scenario before running it. Loads the scenario through the parser,
+// like the server, and reports from the routes alone:
+//   - load: visits to each intersection against its capacity. A visit holds a slot for
+//     the one second a train takes to cross, so visits / capacity is the least time the
+//     intersection is busy
+//   - intersections the routes name but intersections.txt does not (the server FAILs them)
+//   - the intersection-transition graph: how often a route goes from one intersection
+//     straight to another
+//   - opposite orders: pairs of intersections that some trains first reach in one order
+//     and other trains in the other, like Train1 (A, B, C) and Train3 (C, D, A) on A and
+//     C. A train that holds one while it waits for the other can close a circular wait
+//     with a train going the other way. Beyond pairs, the strongly connected components
+//     of the first-reached order are the groups that no single acquisition order fits
+//   - a lower bound on the makespan in seconds
+// Everything is one pass over the routes plus work per distinct intersection pair, so
+// a million trains take well under a second. With the gate options the exit status is
+// 2 when the scenario crosses a limit, so a script can skip an expensive run.
+//
+// usage: ./railcheck [-T trains.txt] [-I intersections.txt] [-S scenario.img] [-n top]
+//                    [-L load] [-C] [-M seconds]
+//   -T, -I, -S  the scenario, as for iLikeTrains (default text_files/ or RAIL_SCENARIO)
+//   -n  rows in each table (default 10)
+//   -L  fail if any intersection's visits / capacity is above load
+//   -C  fail if any two intersections are reached in opposite orders
+//   -M  fail if the makespan lower bound is above seconds
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../parser/parser.h"
+#include "../Basic_IPC_Workflow/scc_analysis.h"
+
+// the pair tables are intersections squared; above this many they are skipped
+#define PAIR_TABLE_MAX 2048
+
+typedef struct {
+    int id;
+    long long visits;
+    int trains;             // distinct trains that visit it
+    double load;            // visits / capacity
+} LoadRow;
+
+typedef struct {
+    int a, b;
+    long long ab, ba;       // trains reaching a first, b first (transitions: a -> b only)
+} PairRow;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int by_load(const void *x, const void *y) {
+    const LoadRow *a = x, *b = y;
+    return (a->load < b->load) - (a->load > b->load);
+}
+
+static int by_pairs(const void *x, const void *y) {
+    const PairRow *a = x, *b = y;
+    long long wa = a->ab * a->ba, wb = b->ab * b->ba;
+    return (wa < wb) - (wa > wb);
+}
+
+static int by_count(const void *x, const void *y) {
+    const PairRow *a = x, *b = y;
+    return (a->ab < b->ab) - (a->ab > b->ab);
+}
+
+int main(int argc, char *argv[]) {
+    const char *trains_path = NULL, *intersections_path = NULL, *image_path = NULL;
+    int top = 10, gate_conflicts = 0;
+    double gate_load = -1, gate_makespan = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "T:I:S:n:L:CM:")) != -1) {
+        switch (opt) {
+        case 'T': trains_path = optarg; break;
+        case 'I': intersections_path = optarg; break;
+        case 'S': image_path = optarg; break;
+        case 'n': top = atoi(optarg); break;
+        case 'L': gate_load = atof(optarg); break;
+        case 'C': gate_conflicts = 1; break;
+        case 'M': gate_makespan = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-T trains.txt] [-I intersections.txt] [-S scenario.img] [-n top]\n"
+                            "       [-L load] [-C] [-M seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    double start = now_ms();
+    Scenario sc;
+    if (scenario_open(&sc, image_path, trains_path, intersections_path) == -1) return 1;
+    double loaded = now_ms();
+
+    int names = sc.names.count, known = sc.intersection_count;
+    int pairs = known <= PAIR_TABLE_MAX;
+    long long *visits = calloc(names, sizeof(long long));
+    int *trains = calloc(names, sizeof(int));
+    int *first_train = malloc(names * sizeof(int));
+    int *last_train = malloc(names * sizeof(int));       // stamp: last train counted in trains[]
+    int *min_head = malloc(known * sizeof(int));         // fewest hops before any visit
+    int *min_tail = malloc(known * sizeof(int));         // fewest hops after any visit
+    int *order = malloc(known * sizeof(int));            // one train's intersections, first reached first
+    size_t cells = pairs ? (size_t)known * known : 0;
+    long long *before = calloc(cells, sizeof(long long)); // [a * known + b]: trains reaching a first
+    long long *step = calloc(cells, sizeof(long long));   // [a * known + b]: hops a -> b
+    int *example = malloc(cells * sizeof(int));          // a train with a before b
+    if (!visits || !trains || !first_train || !last_train || !min_head || !min_tail || !order ||
+        (pairs && (!before || !step || !example))) {
+        perror("railcheck");
+        return 1;
+    }
+    for (int v = 0; v < names; v++) last_train[v] = -1;
+    for (int v = 0; v < known; v++) min_head[v] = min_tail[v] = -1;
+
+    // one pass over every hop
+    int longest = 0;
+    long long hops = 0;
+    for (int t = 0; t < sc.train_count; t++) {
+        TrainEntry te = scenario_train(&sc, t);
+        if (te.routeLength > scenario_route_length(&sc, longest)) longest = t;
+        hops += te.routeLength;
+        int distinct = 0;
+        for (int h = 0; h < te.routeLength; h++) {
+            int v = te.route[h];
+            visits[v]++;
+            if (last_train[v] != t) {
+                if (!trains[v]) first_train[v] = t;
+                trains[v]++;
+                last_train[v] = t;
+                if (v < known) order[distinct++] = v;
+            }
+            if (v >= known) continue;
+            int tail = te.routeLength - h - 1;
+            if (min_head[v] == -1 || h < min_head[v]) min_head[v] = h;
+            if (min_tail[v] == -1 || tail < min_tail[v]) min_tail[v] = tail;
+            if (pairs && h > 0 && te.route[h - 1] < known) step[te.route[h - 1] * known + v]++;
+        }
+        // every pair in the order this train first reaches them: distinct^2, and distinct
+        // is at most the number of intersections
+        if (pairs) {
+            for (int i = 0; i < distinct; i++) {
+                for (int j = i + 1; j < distinct; j++) {
+                    size_t cell = (size_t)order[i] * known + order[j];
+                    if (!before[cell]) example[cell] = t;
+                    before[cell]++;
+                }
+            }
+        }
+    }
+
+    printf("scenario: %d intersections, %d trains, %lld hops (loaded in %.1f ms)\n\n",
+           known, sc.train_count, hops, loaded - start);
+    int failed = 0;
+
+    // load, highest first
+    LoadRow *rows = malloc((known + 1) * sizeof(LoadRow));
+    if (!rows) {
+        perror("railcheck");
+        return 1;
+    }
+    for (int v = 0; v < known; v++) {
+        rows[v].id = v;
+        rows[v].visits = visits[v];
+        rows[v].trains = trains[v];
+        rows[v].load = (double)visits[v] / sc.intersections[v].capacity;
+    }
+    qsort(rows, known, sizeof(LoadRow), by_load);
+    printf("load (visits / capacity, seconds an intersection is busy at the least):\n");
+    printf("  %-24s %8s %10s %10s %10s\n", "intersection", "capacity", "visits", "trains", "load");
+    for (int i = 0; i < known && i < top; i++) {
+        printf("  %-24s %8d %10lld %10d %10.2f\n", scenario_name(&sc, rows[i].id),
+               sc.intersections[rows[i].id].capacity, rows[i].visits, rows[i].trains, rows[i].load);
+    }
+    if (known > 0 && gate_load >= 0 && rows[0].load > gate_load) {
+        fflush(stdout); // the report first, then why it failed
+        fprintf(stderr, "railcheck: %s has load %.2f, above %.2f\n", scenario_name(&sc, rows[0].id),
+                rows[0].load, gate_load);
+        failed = 1;
+    }
+
+    int unknown = names - known;
+    if (unknown > 0) {
+        printf("\nnamed by routes but not in intersections.txt (the server FAILs them): %d\n", unknown);
+        for (int v = known; v < names && v < known + top; v++) {
+            printf("  %-24s %10lld visits, e.g. %s\n", scenario_name(&sc, v), visits[v],
+                   scenario_train(&sc, first_train[v]).id);
+        }
+    }
+
+    // one row per intersection pair, for the transition and opposite order tables
+    PairRow *pair_rows = pairs ? malloc((cells + 1) * sizeof(PairRow)) : NULL;
+    if (pairs && !pair_rows) {
+        perror("railcheck");
+        return 1;
+    }
+    if (!pairs) {
+        printf("\nmore than %d intersections, transition and order tables skipped\n", PAIR_TABLE_MAX);
+    } else {
+        int count = 0, distinct = 0;
+        for (int a = 0; a < known; a++) {
+            for (int b = 0; b < known; b++) {
+                long long n = step[(size_t)a * known + b];
+                if (!n) continue;
+                pair_rows[count++] = (PairRow){ a, b, n, 0 };
+            }
+        }
+        distinct = count;
+        qsort(pair_rows, count, sizeof(PairRow), by_count);
+        printf("\ntransitions: %d distinct, busiest first:\n", distinct);
+        for (int i = 0; i < count && i < top; i++) {
+            printf("  %s -> %s  %lld\n", scenario_name(&sc, pair_rows[i].a), scenario_name(&sc, pair_rows[i].b),
+                   pair_rows[i].ab);
+        }
+
+        // opposite orders, most train pairs first
+        count = 0;
+        int *from = malloc((cells + 1) * sizeof(int)), *to = malloc((cells + 1) * sizeof(int));
+        if (!from || !to) {
+            perror("railcheck");
+            return 1;
+        }
+        int edges = 0;
+        for (int a = 0; a < known; a++) {
+            for (int b = 0; b < known; b++) {
+                long long ab = before[(size_t)a * known + b], ba = before[(size_t)b * known + a];
+                if (ab) {
+                    from[edges] = a;
+                    to[edges++] = b;
+                }
+                if (a < b && ab && ba) pair_rows[count++] = (PairRow){ a, b, ab, ba };
+            }
+        }
+        qsort(pair_rows, count, sizeof(PairRow), by_pairs);
+        printf("\nopposite orders (potential circular waits): %d pair(s) of intersections\n", count);
+        for (int i = 0; i < count && i < top; i++) {
+            PairRow *p = &pair_rows[i];
+            printf("  %s / %s: %lld x %lld trains, e.g. %s (%s first) and %s (%s first)\n",
+                   scenario_name(&sc, p->a), scenario_name(&sc, p->b), p->ab, p->ba,
+                   scenario_train(&sc, example[(size_t)p->a * known + p->b]).id, scenario_name(&sc, p->a),
+                   scenario_train(&sc, example[(size_t)p->b * known + p->a]).id, scenario_name(&sc, p->b));
+        }
+        if (count > 0 && gate_conflicts) {
+            fflush(stdout);
+            fprintf(stderr, "railcheck: %d pair(s) of intersections reached in opposite orders\n", count);
+            failed = 1;
+        }
+
+        // groups that no acquisition order fits: components of the first-reached order
+        SccGraph g;
+        int *comp = malloc((known + 1) * sizeof(int));
+        int *size = calloc(known + 1, sizeof(int));
+        if (!comp || !size || scc_graph_build(&g, known, from, to, edges) == -1) {
+            perror("railcheck");
+            return 1;
+        }
+        int comps = scc_components(&g, 1, comp);
+        if (comps < 0) {
+            fprintf(stderr, "railcheck: out of memory\n");
+            return 1;
+        }
+        for (int v = 0; v < known; v++) size[comp[v]]++;
+        int groups = 0;
+        for (int c = 0; c < comps; c++) {
+            if (size[c] < 2) continue;
+            printf("%s  {", groups++ ? "" : "circular-wait groups (no one acquisition order fits every route):\n");
+            for (int v = 0, n = 0; v < known; v++) {
+                if (comp[v] == c) printf("%s%s", n++ ? ", " : "", scenario_name(&sc, v));
+            }
+            printf("}\n");
+        }
+        if (!groups) printf("every route agrees with one order of the intersections, no circular wait is possible\n");
+        scc_graph_free(&g);
+        free(comp);
+        free(size);
+        free(from);
+        free(to);
+    }
+
+    // Makespan: a train crosses its hops one after another, a second each, so the
+    // longest route is a bound. So is each intersection: it cannot start before the
+    // train closest to it gets there, needs visits / capacity seconds of crossings, and
+    // the last train out still has the rest of its route to go
+    double bound = sc.train_count ? scenario_route_length(&sc, longest) : 0;
+    int bottleneck = -1;
+    for (int v = 0; v < known; v++) {
+        if (!visits[v]) continue;
+        int cap = sc.intersections[v].capacity;
+        double lb = min_head[v] + (double)((visits[v] + cap - 1) / cap) + min_tail[v];
+        if (lb > bound) {
+            bound = lb;
+            bottleneck = v;
+        }
+    }
+    printf("\nmakespan lower bound: %.0f s (", bound);
+    if (bottleneck >= 0) {
+        int cap = sc.intersections[bottleneck].capacity;
+        printf("%s: %d s to reach, %lld s of crossings, %d s after", scenario_name(&sc, bottleneck),
+               min_head[bottleneck], (visits[bottleneck] + cap - 1) / cap, min_tail[bottleneck]);
+    } else {
+        if (sc.train_count) printf("longest route, %s", scenario_train(&sc, longest).id);
+        else printf("no trains");
+    }
+    printf(")\nanalysed in %.1f ms\n", now_ms() - loaded);
+    if (gate_makespan >= 0 && bound > gate_makespan) {
+        fflush(stdout);
+        fprintf(stderr, "railcheck: makespan lower bound %.0f s is above %.0f s\n", bound, gate_makespan);
+        failed = 1;
+    }
+
+    free(rows);
+    free(pair_rows);
+    free(visits);
+    free(trains);
+    free(first_train);
+    free(last_train);
+    free(min_head);
+    free(min_tail);
+    free(order);
+    free(before);
+    free(step);
+    free(example);
+    scenario_free(&sc);
+    return failed ? 2 : 0;
+}
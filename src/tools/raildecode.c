@@ -0,0 +1,110 @@
+// raildecode.c
+// Group: B
+// Date: 10-19-2026
+// Converts binary trace files (RAIL_TRACE) back into readable output. Several files,
+// e.g. the server's and every train's, are merged into one stream by wall time.
+//
+// usage: ./raildecode [-f csv|text] [-o file] trace_*.bin
+//   -f  csv uses the column layout of the LOG_CSV file (default),
+//       text prints simulation.log style lines
+//   -o  write to file instead of stdout
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../logger/trace.h"
+
+#define MAX_TRACE_FILES 64
+
+static const char *name_of(const TraceFile *f, const TraceRecord *r) {
+    if (r->intersection == TRACE_NO_NAME || r->intersection >= f->header->name_count) return "";
+    return f->header->names[r->intersection];
+}
+
+static void print_csv(FILE *out, const TraceFile *f, const TraceRecord *r) {
+    time_t sec = r->wall_ns / 1000000000ULL;
+    struct tm tm_info;
+    char when[32];
+    localtime_r(&sec, &tm_info);
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm_info);
+    const char *status = r->result == TRACE_RES_NONE ? "SENT" : trace_result_name(r->result);
+    fprintf(out, "%s.%09llu,%s,trace,%u,%s,%s,%s,%d,,{},false,{},0,,\n",
+            when, (unsigned long long)(r->wall_ns % 1000000000ULL),
+            f->header->role, r->train_id, name_of(f, r), trace_op_name(r->opcode),
+            status, f->header->pid);
+}
+
+static void print_text(FILE *out, const TraceFile *f, const TraceRecord *r) {
+    unsigned t = r->sim_tick;
+    fprintf(out, "[%02u:%02u:%02u] %s", t / 3600, (t % 3600) / 60, t % 60, f->header->role);
+    if (r->train_id) fprintf(out, " train=%u", r->train_id);
+    fprintf(out, ": %s %s", trace_op_name(r->opcode), name_of(f, r));
+    if (r->result != TRACE_RES_NONE) fprintf(out, " -> %s", trace_result_name(r->result));
+    fputc('\n', out);
+}
+
+int main(int argc, char *argv[]) {
+    int text = 0;
+    const char *out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:o:")) != -1) {
+        switch (opt) {
+        case 'f':
+            if (strcmp(optarg, "text") == 0) text = 1;
+            else if (strcmp(optarg, "csv") == 0) text = 0;
+            else {
+                fprintf(stderr, "format must be csv or text\n");
+                return 1;
+            }
+            break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-f csv|text] [-o file] trace_*.bin\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-f csv|text] [-o file] trace_*.bin\n", argv[0]);
+        return 1;
+    }
+
+    static TraceFile files[MAX_TRACE_FILES];
+    uint64_t next[MAX_TRACE_FILES] = { 0 };
+    int file_count = 0;
+    for (int i = optind; i < argc && file_count < MAX_TRACE_FILES; i++) {
+        if (trace_file_open(argv[i], &files[file_count]) == 0) file_count++;
+    }
+    if (file_count == 0) return 1;
+
+    FILE *out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "w");
+        if (!out) {
+            perror("raildecode: fopen");
+            return 1;
+        }
+    }
+    if (!text) {
+        fprintf(out, "sys_time,calling_file,calling_function,train_id,intersection_id,action,status,pid,error_msg,resource_state,has_deadlock,train_state,node_count,cycle_path,edge_type\n");
+    }
+
+    // k-way merge: each file is already in wall-time order
+    for (;;) {
+        int pick = -1;
+        for (int i = 0; i < file_count; i++) {
+            if (next[i] >= files[i].count) continue;
+            if (pick < 0 || files[i].records[next[i]].wall_ns < files[pick].records[next[pick]].wall_ns) {
+                pick = i;
+            }
+        }
+        if (pick < 0) break;
+        const TraceRecord *r = &files[pick].records[next[pick]++];
+        if (text) print_text(out, &files[pick], r);
+        else print_csv(out, &files[pick], r);
+    }
+
+    if (out != stdout) fclose(out);
+    for (int i = 0; i < file_count; i++) trace_file_close(&files[i]);
+    return 0;
+}
@@ -0,0 +1,48 @@
+// raildump.c
+// Group: B
+// Date: 10-19-2026
+// Prints the flight recorder: the last events of every process merged by sim time,
+// then the holders and wait queues of each intersection. Only reads shared memory,
+// so it is safe on a wedged run and still works after a process crashed.
+//
+// usage: ./raildump [-o file]
+#include <stdio.h>
+#include <unistd.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "../logger/flight_recorder.h"
+
+int main(int argc, char *argv[]) {
+    const char *out_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:")) != -1) {
+        switch (opt) {
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-o file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FlightRegion *region = flight_open_readonly();
+    if (!region) {
+        fprintf(stderr, "raildump: no flight recorder in shared memory, or one from an older build\n");
+        return 1;
+    }
+    size_t size;
+    SharedIntersection *shared = attach_shared_memory("/intersection_shm", &size);
+    if (!shared) {
+        fprintf(stderr, "raildump: intersection shared memory not found, events only\n");
+    }
+
+    FILE *out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "w");
+        if (!out) {
+            perror("raildump: fopen");
+            return 1;
+        }
+    }
+    flight_dump(out, region, shared);
+    if (out != stdout) fclose(out);
+    return 0;
+}
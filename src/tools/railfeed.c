@@ -0,0 +1,108 @@
+// railfeed.c
+// Group: B
+// Date: 10-19-2026
+// Train feed for train_sim -s. Writes n trains with random routes over the
+// intersections of intersections.txt, arriving at a set rate, as timestamped lines
+// "offset_ms TrainN:hop,hop,..." followed by END. train_sim starts each train at its
+// offset whatever the trains before it are doing, so the arrival rate is the feed's
+// and not the server's (an open-loop load):
+//
+//   ./railfeed -n 200 -r 5 > feed.txt && ./train_sim -s feed.txt
+//   mkfifo feed; ./train_sim -s feed & ./railfeed -n 200 -r 5 -l > feed
+//
+// -l writes each line when its train is due, without the offset, for a consumer that
+// should see the trains arrive one at a time.
+//
+// usage: ./railfeed [-n trains] [-r per_second] [-a poisson|fixed] [-k hops]
+//                   [-I intersections.txt] [-f first] [-x seed] [-l]
+//   -n  trains (default 20), numbered Train<first>... (default first 1)
+//   -r  arrivals per second (default 1)
+//   -a  gaps between arrivals: exponential (poisson, the default) or all 1/rate (fixed)
+//   -k  hops per route (default 3), no intersection twice in a row
+//   -x  random seed (default 1), the same seed gives the same feed
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../parser/parser.h"
+
+static void sleep_until(const struct timespec *start, double offset_ms) {
+    struct timespec due = *start;
+    long long ns = (long long)(offset_ms * 1e6) + due.tv_nsec;
+    due.tv_sec += ns / 1000000000LL;
+    due.tv_nsec = ns % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) != 0) {
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int trains = 20, hops = 3, first = 1, live = 0, poisson = 1;
+    double rate = 1.0;
+    unsigned int seed = 1;
+    const char *intersections = INTERSECTIONS_FILE;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:a:k:I:f:x:l")) != -1) {
+        switch (opt) {
+        case 'n': trains = atoi(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'a':
+            if (strcmp(optarg, "poisson") == 0) poisson = 1;
+            else if (strcmp(optarg, "fixed") == 0) poisson = 0;
+            else {
+                fprintf(stderr, "railfeed: arrivals must be poisson or fixed\n");
+                return 1;
+            }
+            break;
+        case 'k': hops = atoi(optarg); break;
+        case 'I': intersections = optarg; break;
+        case 'f': first = atoi(optarg); break;
+        case 'x': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+        case 'l': live = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n trains] [-r per_second] [-a poisson|fixed] [-k hops]\n"
+                            "       [-I intersections.txt] [-f first] [-x seed] [-l]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (trains < 0 || rate <= 0 || hops < 1 || first < 1) {
+        fprintf(stderr, "railfeed: trains must be >= 0, rate > 0, hops and first >= 1\n");
+        return 1;
+    }
+
+    Scenario sc;
+    if (scenario_init(&sc) == -1 || scenario_parse_intersections(&sc, intersections) == -1) return 1;
+    if (sc.intersection_count == 0) {
+        fprintf(stderr, "railfeed: %s has no intersections\n", intersections);
+        scenario_free(&sc);
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double offset_ms = 0;
+    for (int t = 0; t < trains; t++) {
+        // the first train comes one gap after the start, like every other
+        double u = (rand_r(&seed) + 1.0) / ((double)RAND_MAX + 2.0);
+        offset_ms += 1000.0 / rate * (poisson ? -log(u) : 1.0);
+        if (live) {
+            sleep_until(&start, offset_ms);
+            printf("Train%d:", first + t);
+        } else {
+            printf("%lld Train%d:", (long long)offset_ms, first + t);
+        }
+        int last = -1;
+        for (int h = 0; h < hops; h++) {
+            int id = rand_r(&seed) % sc.intersection_count;
+            if (id == last && sc.intersection_count > 1) id = (id + 1) % sc.intersection_count;
+            printf("%s%s", h ? "," : "", scenario_name(&sc, id));
+            last = id;
+        }
+        printf("\n");
+        if (live) fflush(stdout);
+    }
+    printf("END\n");
+    scenario_free(&sc);
+    return 0;
+}
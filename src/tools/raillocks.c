@@ -0,0 +1,59 @@
+// raillocks.c
+// Group: B
+// Date: 10-19-2026
+// Lock contention report for a running simulation. Lists every intersection mutex,
+// split by who took it (holder/waiter tracking or the sim clock), ranked by the time
+// processes spent blocked on it. Profiling is switched in the stats region, so it can
+// be turned on and off without restarting anything (RAIL_LOCK_PROFILE=1 turns it on
+// from the start).
+//
+// usage: ./raillocks            print the report
+//        ./raillocks on|off     start or stop counting
+//        ./raillocks reset      zero the counters
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+
+int main(int argc, char *argv[]) {
+    const char *cmd = argc > 1 ? argv[1] : "report";
+    int report = strcmp(cmd, "report") == 0;
+    if (!report && strcmp(cmd, "on") != 0 && strcmp(cmd, "off") != 0 && strcmp(cmd, "reset") != 0) {
+        fprintf(stderr, "usage: %s [report|on|off|reset]\n", argv[0]);
+        return 1;
+    }
+
+    // switching needs a writable mapping; reporting stays read-only like the other monitors
+    int shm_fd = shm_open("/intersection_shm", report ? O_RDONLY : O_RDWR, 0);
+    if (shm_fd == -1) {
+        perror("raillocks: shm_open /intersection_shm");
+        return 1;
+    }
+    int prot = report ? PROT_READ : PROT_READ | PROT_WRITE;
+    SharedIntersection *shared = mmap(NULL, SHM_SEGMENT_SIZE, prot, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (shared == MAP_FAILED) {
+        perror("raillocks: mmap");
+        return 1;
+    }
+    RailStats *stats = shm_stats(shared);
+    if (stats->magic != RAIL_STATS_MAGIC) {
+        fprintf(stderr, "raillocks: stats region not initialized yet\n");
+        return 1;
+    }
+
+    if (strcmp(cmd, "on") == 0 || strcmp(cmd, "off") == 0) {
+        __atomic_store_n(&stats->lock_profiling, strcmp(cmd, "on") == 0, __ATOMIC_RELAXED);
+        printf("lock profiling %s\n", cmd);
+    } else if (strcmp(cmd, "reset") == 0) {
+        stats_reset_locks(stats);
+        printf("lock counters reset\n");
+    } else {
+        printf("lock profiling is %s\n", __atomic_load_n(&stats->lock_profiling, __ATOMIC_RELAXED) ? "on" : "off");
+        stats_print_locks(stdout, stats);
+    }
+    munmap(shared, SHM_SEGMENT_SIZE);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// railscc.c
+// Group: B
+// Date: 10-19-2026
+// Offline deadlock analysis of a recorded graph. Reads an edge list (the railwfg output,
+// or any file of "from to" pairs, '#' lines are comments), finds every strongly connected
+// component and prints each deadlocked set with all of its members.
+//
+// usage: ./railscc [-t threads] [-q] [file]
+//   -t  worker threads (default: one per core, 1 = serial Tarjan)
+//   -q  only print the number of deadlocked sets
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../Basic_IPC_Workflow/scc_analysis.h"
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+// index of id in the sorted, unique ids[]
+static int lookup(const long ids[], int n, long id) {
+    int lo = 0, hi = n - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ids[mid] < id) lo = mid + 1;
+        else if (ids[mid] > id) hi = mid - 1;
+        else return mid;
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int quiet = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:q")) != -1) {
+        switch (opt) {
+        case 't': threads = atoi(optarg); break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-t threads] [-q] [file]\n", argv[0]);
+            return 1;
+        }
+    }
+    FILE *in = stdin;
+    if (optind < argc) {
+        in = fopen(argv[optind], "r");
+        if (!in) {
+            perror("railscc: fopen");
+            return 1;
+        }
+    }
+
+    // read the raw edges
+    size_t cap = 1 << 16, edges = 0;
+    long *raw_from = malloc(cap * sizeof(long));
+    long *raw_to = malloc(cap * sizeof(long));
+    char line[256];
+    while (raw_from && raw_to && fgets(line, sizeof(line), in)) {
+        long a, b;
+        if (line[0] == '#' || sscanf(line, "%ld %ld", &a, &b) != 2) continue;
+        if (edges == cap) {
+            cap *= 2;
+            raw_from = realloc(raw_from, cap * sizeof(long));
+            raw_to = realloc(raw_to, cap * sizeof(long));
+            if (!raw_from || !raw_to) break;
+        }
+        raw_from[edges] = a;
+        raw_to[edges++] = b;
+    }
+    if (in != stdin) fclose(in);
+    if (!raw_from || !raw_to) {
+        fprintf(stderr, "railscc: out of memory\n");
+        return 1;
+    }
+
+    // map IDs onto 0..n-1
+    long *ids = malloc((2 * edges + 1) * sizeof(long));
+    int *from = malloc((edges + 1) * sizeof(int));
+    int *to = malloc((edges + 1) * sizeof(int));
+    if (!ids || !from || !to) {
+        fprintf(stderr, "railscc: out of memory\n");
+        return 1;
+    }
+    memcpy(ids, raw_from, edges * sizeof(long));
+    memcpy(ids + edges, raw_to, edges * sizeof(long));
+    qsort(ids, 2 * edges, sizeof(long), cmp_long);
+    int n = 0;
+    for (size_t i = 0; i < 2 * edges; i++) {
+        if (n == 0 || ids[n - 1] != ids[i]) ids[n++] = ids[i];
+    }
+    for (size_t e = 0; e < edges; e++) {
+        from[e] = lookup(ids, n, raw_from[e]);
+        to[e] = lookup(ids, n, raw_to[e]);
+    }
+    free(raw_from);
+    free(raw_to);
+
+    SccGraph g;
+    int *comp = malloc(((size_t)n + 1) * sizeof(int));
+    if (!comp || scc_graph_build(&g, n, from, to, (int)edges) != 0) {
+        fprintf(stderr, "railscc: out of memory\n");
+        return 1;
+    }
+    free(from);
+    free(to);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int comp_count = scc_components(&g, threads, comp);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (comp_count < 0) {
+        fprintf(stderr, "railscc: out of memory\n");
+        return 1;
+    }
+    fprintf(stderr, "%d nodes, %zu edges, %d components in %.3f s (%d threads)\n",
+            n, edges, comp_count,
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9, threads);
+
+    if (quiet) {
+        char *deadlocked = malloc((size_t)comp_count + 1);
+        printf("%d deadlocked set(s)\n", deadlocked ? scc_deadlocked_sets(&g, comp, comp_count, deadlocked) : -1);
+        free(deadlocked);
+    } else {
+        scc_print_deadlocked_sets(stdout, &g, comp, comp_count, ids);
+    }
+
+    scc_graph_free(&g);
+    free(comp);
+    free(ids);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// railstat.c
+// Group: B
+// Date: 10-19-2026
+// vmstat for the railway. Attaches read-only to /intersection_shm and prints one line
+// per interval: request and reply rates from the stats counters, the message queue
+// depth (msgctl IPC_STAT), how fast the sim clock runs, and for every intersection
+// its holders against capacity and its waiters. Holders and waiters come from the
+// seqlock snapshots and the counters are plain atomic loads, so railstat never takes
+// a SharedIntersection mutex and cannot slow the server down.
+//
+// usage: ./railstat [-i seconds] [-c count]
+//   -i  seconds between lines (default 1)
+//   -c  stop after this many lines (default: until the simulation ends)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "../Basic_IPC_Workflow/ipc.h"   // MSG_KEY
+
+#define HEADER_EVERY 20
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_header(const RailStats *stats) {
+    printf("%8s %8s %8s %7s %7s %5s %5s %6s %7s", "sim", "req/s", "grant/s", "wait/s",
+           "rel/s", "tmo", "fail", "queue", "clock");
+    for (int i = 0; i < stats->intersection_count && i < NUM_INTERSECTIONS; i++) {
+        // "IntersectionA" -> "A", the column is too narrow for the full name
+        const char *name = stats->names[i];
+        if (strncmp(name, "Intersection", 12) == 0 && name[12] != '\0') name += 12;
+        printf(" %9.9s", name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    double interval = 1.0;
+    long max_lines = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:c:")) != -1) {
+        switch (opt) {
+        case 'i': interval = atof(optarg); break;
+        case 'c': max_lines = atol(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-i seconds] [-c count]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (interval <= 0) interval = 1.0;
+
+    size_t size;
+    SharedIntersection *shared = attach_shared_memory("/intersection_shm", &size);
+    if (!shared) {
+        fprintf(stderr, "railstat: simulation shared memory not found\n");
+        return 1;
+    }
+    const RailStats *stats = shm_stats(shared);
+
+    uint64_t prev[STAT_COUNTERS];
+    for (int c = 0; c < STAT_COUNTERS; c++) prev[c] = __atomic_load_n(&stats->counters[c], __ATOMIC_RELAXED);
+    int prev_sim = __atomic_load_n(&shared[0].fakeSec, __ATOMIC_RELAXED);
+    double prev_wall = wall_seconds();
+
+    for (long line = 0; max_lines < 0 || line < max_lines; line++) {
+        struct timespec pause = { (time_t)interval, (long)((interval - (time_t)interval) * 1e9) };
+        nanosleep(&pause, NULL);
+
+        // the server removes the queue on STOP, that is the end of the run
+        int msgid = msgget(MSG_KEY, 0);
+        struct msqid_ds qs;
+        if (msgid < 0 || msgctl(msgid, IPC_STAT, &qs) == -1) {
+            printf("simulation ended\n");
+            break;
+        }
+
+        if (line % HEADER_EVERY == 0) print_header(stats);
+
+        double now = wall_seconds();
+        double elapsed = now - prev_wall;
+        uint64_t cur[STAT_COUNTERS];
+        for (int c = 0; c < STAT_COUNTERS; c++) cur[c] = __atomic_load_n(&stats->counters[c], __ATOMIC_RELAXED);
+        int sim = __atomic_load_n(&shared[0].fakeSec, __ATOMIC_RELAXED);
+
+        printf("%02d:%02d:%02d %8.1f %8.1f %7.1f %7.1f %5llu %5llu %6lu %6.1fx",
+               sim / 3600, (sim % 3600) / 60, sim % 60,
+               (cur[STAT_REQUESTS] - prev[STAT_REQUESTS]) / elapsed,
+               (cur[STAT_GRANTS] - prev[STAT_GRANTS]) / elapsed,
+               (cur[STAT_WAITS] - prev[STAT_WAITS]) / elapsed,
+               (cur[STAT_RELEASES] - prev[STAT_RELEASES]) / elapsed,
+               (unsigned long long)(cur[STAT_TIMEOUTS] - prev[STAT_TIMEOUTS]),
+               (unsigned long long)(cur[STAT_FAILS] - prev[STAT_FAILS]),
+               (unsigned long)qs.msg_qnum, (sim - prev_sim) / elapsed);
+
+        // holders/capacity and waiters, e.g. "2/3 w1"
+        for (int i = 0; i < stats->intersection_count && i < NUM_INTERSECTIONS; i++) {
+            IntersectionSnapshot snap;
+            char cell[16];
+            if (snapshot_intersection(shared, i, &snap)) {
+                snprintf(cell, sizeof(cell), "%d/%d w%d", snap.held_count, snap.capacity, snap.wait_count);
+            } else {
+                snprintf(cell, sizeof(cell), "busy");
+            }
+            printf(" %9s", cell);
+        }
+        printf("\n");
+        fflush(stdout);
+
+        memcpy(prev, cur, sizeof(prev));
+        prev_sim = sim;
+        prev_wall = now;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// railwfg.c
+// Group: B
+// Date: 10-19-2026
+// Attaches read-only to /intersection_shm, takes a wait-for graph snapshot and reports
+// any cycle. The graph can be written out for offline analysis. Never takes the
+// intersection mutexes, so it is safe to run against a live server.
+//
+// usage: ./railwfg [-o file] [-i seconds] [-n intersections]
+//   -o  write the edge list to file instead of stdout
+//   -i  keep taking snapshots every N seconds (default: once)
+//   -n  number of intersections to read (default NUM_INTERSECTIONS)
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../Shared_Memory_Setup/Memory_Segments.h"
+#include "../Basic_IPC_Workflow/wait_for_graph.h"
+
+int main(int argc, char *argv[]) {
+    const char *out_path = NULL;
+    int interval = 0;
+    int count = NUM_INTERSECTIONS;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:i:n:")) != -1) {
+        switch (opt) {
+        case 'o': out_path = optarg; break;
+        case 'i': interval = atoi(optarg); break;
+        case 'n': count = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-o file] [-i seconds] [-n intersections]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    size_t size;
+    SharedIntersection *shared = attach_shared_memory("/intersection_shm", &size);
+    if (!shared) {
+        fprintf(stderr, "railwfg: simulation shared memory not found\n");
+        return 1;
+    }
+
+    static WaitForGraph g; // too big for the stack
+    do {
+        wfg_snapshot(shared, count, &g);
+
+        FILE *out = stdout;
+        if (out_path) {
+            out = fopen(out_path, "w");
+            if (!out) {
+                perror("railwfg: fopen");
+                return 1;
+            }
+        }
+        wfg_export(&g, out);
+        if (out != stdout) fclose(out);
+
+        int cycle[MAX_TRAINS];
+        int len = 0;
+        if (wfg_find_cycle(&g, cycle, &len)) {
+            fprintf(stderr, "[%d] deadlock: ", g.sim_sec);
+            for (int i = 0; i < len; i++) fprintf(stderr, "Train %d -> ", cycle[i]);
+            fprintf(stderr, "Train %d\n", cycle[0]);
+        } else {
+            fprintf(stderr, "[%d] no cycle (%d wait edges)\n", g.sim_sec, g.edge_count);
+        }
+
+        if (interval > 0) sleep(interval);
+    } while (interval > 0);
+
+    return 0;
+}